@@ -0,0 +1,43 @@
+/**
+ * File: arena.cpp
+ * ---------------
+ * This file contains the implementation for the MolArena interface.
+ * Documentation for each method can be found in the arena.h file.
+ */
+
+#include "arena.h"
+
+MolArena::MolArena(size_t size) : blockSize(size), current(0), offset(0) {}
+
+MolArena::~MolArena() {
+    for (const Block& block : blocks) ::operator delete(block.memory);
+}
+
+void* MolArena::allocate(size_t bytes, size_t alignment) {
+    while (current < blocks.size()) {
+        size_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+        if (aligned + bytes <= blocks[current].size) {
+            offset = aligned + bytes;
+            return blocks[current].memory + aligned;
+        }
+        current++; // move on to the next kept block
+        offset = 0;
+    }
+    // every kept block is full: add one big enough for this request
+    size_t size = bytes + alignment > blockSize ? bytes + alignment : blockSize;
+    blocks.push_back({static_cast<char*>(::operator new(size)), size});
+    current = blocks.size() - 1;
+    offset = 0;
+    return allocate(bytes, alignment);
+}
+
+void MolArena::reset() {
+    current = 0;
+    offset = 0;
+}
+
+size_t MolArena::getBytesReserved() const {
+    size_t total = 0;
+    for (const Block& block : blocks) total += block.size;
+    return total;
+}
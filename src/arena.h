@@ -0,0 +1,95 @@
+/**
+ * File: arena.h
+ * -------------
+ * This file contains the interface for the MolArena class.
+ * A MolArena is a bump allocator for the atoms and bonds of one
+ * molecule at a time. Allocation just advances a pointer inside a
+ * block, nothing is freed individually, and reset() releases
+ * everything at once while keeping the blocks for the next molecule.
+ * Once the blocks have grown to fit the largest molecule seen, a
+ * worker that owns an arena stops calling the system allocator.
+ *
+ * An arena is not thread-safe; each worker thread owns its own.
+ */
+
+#ifndef _arena_h
+#define _arena_h
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+class MolArena {
+public:
+    /**
+     * Constructor: MolArena
+     * Parameters: blockSize
+     * Usage: MolArena arena;
+     * ----------------------
+     * Initializes an empty arena that grows in blocks of blockSize bytes.
+     */
+    MolArena(size_t blockSize = 64 * 1024);
+
+    /**
+     * Destructor: ~MolArena
+     * Usage: (implicit)
+     * -----------------
+     * Frees every block. Objects still in the arena are not destroyed.
+     */
+    ~MolArena();
+
+    MolArena(const MolArena&) = delete;
+    MolArena& operator=(const MolArena&) = delete;
+
+    /**
+     * Function: allocate
+     * Parameters: bytes, alignment
+     * Usage: void* memory = arena.allocate(bytes, alignment);
+     * -------------------------------------------------------
+     * Returns uninitialized memory that stays valid until the next reset.
+     */
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    /**
+     * Function: create
+     * Parameters: args
+     * Usage: Atom * atom = arena.create<Atom>(token);
+     * -----------------------------------------------
+     * Constructs an object in the arena. The arena never runs its destructor;
+     * call it explicitly before reset if the object holds other resources.
+     */
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * Function: reset
+     * Usage: arena.reset();
+     * ---------------------
+     * Releases everything allocated so far in one step, keeping the blocks.
+     */
+    void reset();
+
+    /**
+     * Function: getBytesReserved
+     * Usage: size_t bytes = arena.getBytesReserved();
+     * -----------------------------------------------
+     * Returns the total size of the blocks the arena holds.
+     */
+    size_t getBytesReserved() const;
+
+private:
+    struct Block {
+        char* memory;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    size_t blockSize;
+    size_t current; // index of the block being filled
+    size_t offset;  // first free byte in that block
+};
+
+#endif
@@ -0,0 +1,114 @@
+/**
+ * File: arrayview.h
+ * -----------------
+ * This file contains the interface and implementation for the ArrayView
+ * class template. An ArrayView is a read-only window onto a contiguous
+ * array owned by someone else, such as the atoms of a Molecule. It is
+ * two words wide and copying it never copies the elements, so
+ * accessors can hand one out instead of a copy of the whole container.
+ * A view is only valid while its owner is alive and unmodified.
+ */
+
+#ifndef _arrayview_h
+#define _arrayview_h
+
+#include <cstddef>
+#include "error.h"
+
+template <typename ValueType>
+class ArrayView {
+public:
+    /**
+     * Constructor: ArrayView
+     * Usage: ArrayView<int> view;
+     * ---------------------------
+     * Initializes an empty view.
+     */
+    ArrayView() : elements(nullptr), count(0) {}
+
+    /**
+     * Constructor: ArrayView
+     * Parameters: elements, count
+     * Usage: ArrayView<int> view(elements, count);
+     * --------------------------------------------
+     * Initializes a view onto count elements starting at elements.
+     */
+    ArrayView(const ValueType* elements, size_t count) : elements(elements), count(count) {}
+
+    /**
+     * Function: size
+     * Usage: int n = view.size();
+     * ---------------------------
+     * Returns the number of elements in the view.
+     */
+    int size() const {
+        return count;
+    }
+
+    /**
+     * Function: isEmpty
+     * Usage: if (view.isEmpty()) {...}
+     * --------------------------------
+     * Returns true if the view has no elements.
+     */
+    bool isEmpty() const {
+        return count == 0;
+    }
+
+    /**
+     * Operator: []
+     * Usage: view[index]
+     * ------------------
+     * Returns the element at the given index, which must be in range.
+     */
+    const ValueType& operator[](int index) const {
+        if (index < 0 || index >= (int) count) {
+            error("ArrayView::operator []: index out of range");
+        }
+        return elements[index];
+    }
+
+    /**
+     * Function: back
+     * Usage: ValueType last = view.back();
+     * ------------------------------------
+     * Returns the last element. The view must not be empty.
+     */
+    const ValueType& back() const {
+        return (*this)[count - 1];
+    }
+
+    /**
+     * Function: indexOf
+     * Parameters: value
+     * Usage: int index = view.indexOf(value);
+     * ---------------------------------------
+     * Returns the index of the first element equal to value, or -1.
+     */
+    int indexOf(const ValueType& value) const {
+        for (size_t i = 0; i < count; ++i) {
+            if (elements[i] == value) return i;
+        }
+        return -1;
+    }
+
+    /**
+     * Functions: begin, end
+     * Usage: for (ValueType value : view) {...}
+     * -----------------------------------------
+     * Support range-based for loops over the view.
+     */
+    const ValueType* begin() const {
+        return elements;
+    }
+
+    const ValueType* end() const {
+        return elements + count;
+    }
+
+private:
+    const ValueType* elements;
+    size_t count;
+};
+
+#endif
@@ -61,6 +61,20 @@ int Atom::getCharge() {
     return charge;
 }
 
+void Atom::setBracket(bool brkt) {
+    bracket = brkt;
+}
+bool Atom::isBracket() {
+    return bracket;
+}
+
+void Atom::setIndex(int idx) {
+    index = idx;
+}
+int Atom::getIndex() {
+    return index;
+}
+
 /**
  ******************************************************************
  ******************************************************************
@@ -69,12 +83,27 @@ int Atom::getCharge() {
  ******************************************************************
  */
 void Atom::setAllSpecials() {
+    setElement();
     if (isIsotope()) setIsotope();
     if (isChiral()) setChirality();
     if (isCharged()) setCharge();
     if (hasHydrogen()) setHydrogens();
 }
 
+void Atom::setElement() {
+    size_t strpos = 0;
+    while (strpos < token.size() && isDigit(token[strpos])) strpos++; // skip the isotope mass
+    if (strpos == token.size()) return;
+    size_t length = 1;
+    if (isupper((unsigned char) token[strpos])) { // e.g. C, Cl, Co (hydrogen counts are uppercase H)
+        if (strpos + 1 < token.size() && islower((unsigned char) token[strpos + 1])) length = 2;
+    } else if (strpos + 1 < token.size()) { // aromatic two-letter elements: se, as, te
+        std::string pair = token.substr(strpos, 2);
+        if (pair == "se" || pair == "as" || pair == "te") length = 2;
+    }
+    abbr = token.substr(strpos, length);
+}
+
 bool Atom::isIsotope() {
     return isDigit(token[0]);
 }
@@ -102,23 +131,38 @@ void Atom::setChirality() {
 }
 
 bool Atom::hasHydrogen() {
-    size_t hLoc = token.find('H');
+    size_t hLoc = findHydrogen();
     if (hLoc == std::string::npos) {
         return false;
     } else {
-        if (isalpha(token[hLoc + 1])) return false; // ignore atoms like Helium
+        if (isalpha((unsigned char) token[hLoc + 1])) return false; // ignore atoms like Helium
         return true;
     }
 }
 
 void Atom::setHydrogens() {
     hcount = 1;
-    size_t hLoc = token.find('H');
+    size_t hLoc = findHydrogen();
     if (hLoc + 1 < token.size() && isDigit(token[hLoc + 1])) {
         hcount = charToInteger(token[hLoc + 1]);
     }
 }
 
+size_t Atom::findHydrogen() {
+    size_t strpos = token.find(abbr) + abbr.size(); // skip the element itself, as in [H+]
+    if (strpos < token.size() && token[strpos] == '@') { // and a chirality class, as in [C@TH1]
+        strpos++;
+        if (strpos < token.size() && token[strpos] == '@') {
+            strpos++;
+        } else if (strpos + 2 < token.size() && isupper((unsigned char) token[strpos]) &&
+                   isupper((unsigned char) token[strpos + 1]) && isDigit(token[strpos + 2])) {
+            strpos += 3;
+            if (strpos < token.size() && isDigit(token[strpos])) strpos++;
+        }
+    }
+    return token.find('H', strpos);
+}
+
 bool Atom::isCharged() {
     return token.find('+') != std::string::npos ||
            token.find('-') != std::string::npos;
@@ -140,11 +184,12 @@ void Atom::setCharge() {
             chrg += increment;
             i++;
         }
+        charge = chrg;
     }
 }
 
 bool Atom::isAromatic() {
-    return islower(abbr[0]);
+    return islower((unsigned char) abbr[0]);
 }
 
 bool isDigit(const char& c){
@@ -6,6 +6,9 @@
  * such as its name and various chemical properties.
  */
 
+#ifndef _atom_h
+#define _atom_h
+
 #include <string>
 #include "strlib.h"
 
@@ -138,6 +141,43 @@ public:
      */
     bool isAromatic();
 
+    /**
+     * Function: setBracket
+     * Parameters: bracket
+     * Usage: atom.setBracket(true);
+     * -----------------------------
+     * Records whether the atom was written in brackets in its SMILES.
+     */
+    void setBracket(bool bracket);
+
+    /**
+     * Function: isBracket
+     * Usage: if (atom.isBracket()) {...}
+     * ----------------------------------
+     * Returns true if the atom was written in brackets, in which case its
+     * hydrogen count is exactly the one written. Atoms of the organic subset
+     * carry implicit hydrogens instead.
+     */
+    bool isBracket();
+
+    /**
+     * Function: setIndex
+     * Parameters: idx
+     * Usage: atom.setIndex(idx);
+     * --------------------------
+     * Sets the position of the atom within its molecule.
+     */
+    void setIndex(int idx);
+
+    /**
+     * Function: getIndex
+     * Usage: int idx = atom.getIndex();
+     * ---------------------------------
+     * Returns the position of the atom within its molecule, or -1 if
+     * the atom has not been added to a molecule.
+     */
+    int getIndex();
+
     /**
      * Function: setAllSpecials
      * Usage: atom.setAllSpecials();
@@ -151,15 +191,21 @@ private:
     std::string token, abbr, name;
 
     // chemical properties
-    int isotope; 
+    int isotope = 0;
     std::string chiralClass;
     int hcount = 0;
     int charge = 0;
+    bool bracket = false;
+
+    // position in the owning molecule's atom list
+    int index = -1;
 
     /* METHODS FOR SETTING SPECIAL PROPERTIES:
      * 1. checks to see if the token has certain qualities
      * 2. if so, take those qualities and put them into private data members
      */
+    void setElement(); // the element symbol always comes from the token
+
     bool isIsotope();
     void setIsotope();
 
@@ -168,7 +214,10 @@ private:
 
     bool hasHydrogen();
     void setHydrogens();
+    size_t findHydrogen(); // the first 'H' past the element and chirality, or npos
 
     bool isCharged();
     void setCharge();
 };
+
+#endif
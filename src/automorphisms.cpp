@@ -0,0 +1,323 @@
+/**
+ * File: automorphisms.cpp
+ * -----------------------
+ * This file contains the implementation for the Automorphisms interface.
+ * Documentation for each method can be found in the automorphisms.h file.
+ */
+
+#include <algorithm>
+#include <numeric>
+#include "automorphisms.h"
+
+// gives up on one search for a permutation after this many steps per atom
+static const int SEARCH_STEPS_PER_ATOM = 100;
+
+// helper function declarations
+static int findRoot(std::vector<int>& parent, int x);
+static void unite(std::vector<int>& parent, int a, int b);
+static int flatten(std::vector<int>& parent);
+
+Automorphisms::Automorphisms() :
+    natoms(0), nbonds(0), numAtomOrbits(0), numBondOrbits(0), complete(true), graph(nullptr) {}
+
+Automorphisms::Automorphisms(const Molecule& mol) :
+    natoms(0), nbonds(0), numAtomOrbits(0), numBondOrbits(0), complete(true), graph(nullptr) {
+    compute(mol);
+}
+
+void Automorphisms::compute(const Molecule& mol) {
+    ownHash.compute(mol);
+    compute(mol, ownHash);
+}
+
+void Automorphisms::compute(const Molecule& mol, const GraphHash& hash) {
+    ArrayView<Atom*> atoms = mol.getAtoms();
+    ArrayView<Bond*> bonds = mol.getBonds();
+    natoms = atoms.size();
+    nbonds = bonds.size();
+    complete = true;
+    graph = &hash;
+
+    // the atom labels, to check permutations against
+    labels.resize(natoms);
+    for (int i = 0; i < natoms; ++i) labels[i] = GraphHash::atomLabel(atoms[i]);
+    bondAtoms.resize(2 * nbonds);
+    bondOrder.resize(nbonds);
+    adjStart.assign(natoms + 1, 0);
+    for (int i = 0; i < nbonds; ++i) {
+        bondAtoms[2 * i] = bonds[i]->getFirstAtom()->getIndex();
+        bondAtoms[2 * i + 1] = bonds[i]->getSecondAtom()->getIndex();
+        bondOrder[i] = bonds[i]->getOrder();
+        adjStart[bondAtoms[2 * i] + 1]++;
+        adjStart[bondAtoms[2 * i + 1] + 1]++;
+    }
+    std::partial_sum(adjStart.begin(), adjStart.end(), adjStart.begin());
+    adjAtom.resize(adjStart[natoms]);
+    adjBond.resize(adjStart[natoms]);
+    next.assign(adjStart.begin(), adjStart.end() - 1); // fill positions
+    for (int i = 0; i < nbonds; ++i) {
+        int a = bondAtoms[2 * i], b = bondAtoms[2 * i + 1];
+        adjAtom[next[a]] = b;
+        adjBond[next[a]++] = i;
+        adjAtom[next[b]] = a;
+        adjBond[next[b]++] = i;
+    }
+
+    atomParent.resize(natoms);
+    std::iota(atomParent.begin(), atomParent.end(), 0);
+    bondParent.resize(nbonds);
+    std::iota(bondParent.begin(), bondParent.end(), 0);
+    const std::vector<uint64_t>& baseColors = hash.getColors();
+
+    // atom orbits: within each colour class, prove each atom equivalent to an
+    // earlier orbit or make it the representative of a new one
+    members.resize(natoms);
+    std::iota(members.begin(), members.end(), 0);
+    std::stable_sort(members.begin(), members.end(), [&](int x, int y) {
+        return baseColors[x] < baseColors[y];
+    });
+    std::vector<int> representatives;
+    for (int start = 0, end; start < natoms; start = end) {
+        for (end = start + 1; end < natoms && baseColors[members[end]] == baseColors[members[start]]; ++end) {}
+        representatives.clear();
+        for (int k = start; k < end; ++k) {
+            int atom = members[k];
+            bool found = false;
+            for (int rep : representatives) {
+                if (findRoot(atomParent, rep) == findRoot(atomParent, atom)) found = true;
+            }
+            for (size_t r = 0; !found && r < representatives.size(); ++r) {
+                if (findAutomorphism({representatives[r]}, {atom})) {
+                    merge();
+                    found = true;
+                }
+            }
+            if (!found) representatives.push_back(atom);
+        }
+    }
+
+    // bond orbits: the permutations found so far may not relate every pair of
+    // equivalent bonds, so bonds joining the same two atom orbits are checked
+    // in the same way, fixing both ends
+    auto endsOf = [&](int bond) {
+        int a = findRoot(atomParent, bondAtoms[2 * bond]), b = findRoot(atomParent, bondAtoms[2 * bond + 1]);
+        return std::make_pair(std::min(a, b), std::max(a, b));
+    };
+    members.resize(nbonds);
+    std::iota(members.begin(), members.end(), 0);
+    std::stable_sort(members.begin(), members.end(), [&](int x, int y) {
+        return std::make_pair(endsOf(x), bondOrder[x]) < std::make_pair(endsOf(y), bondOrder[y]);
+    });
+    for (int start = 0, end; start < nbonds; start = end) {
+        for (end = start + 1; end < nbonds && endsOf(members[end]) == endsOf(members[start]) &&
+                              bondOrder[members[end]] == bondOrder[members[start]]; ++end) {}
+        representatives.clear();
+        for (int k = start; k < end; ++k) {
+            int bond = members[k];
+            int u = bondAtoms[2 * bond], v = bondAtoms[2 * bond + 1];
+            bool found = false;
+            for (int rep : representatives) {
+                if (findRoot(bondParent, rep) == findRoot(bondParent, bond)) found = true;
+            }
+            for (size_t r = 0; !found && r < representatives.size(); ++r) {
+                int x = bondAtoms[2 * representatives[r]], y = bondAtoms[2 * representatives[r] + 1];
+                if ((findRoot(atomParent, x) == findRoot(atomParent, u) && findAutomorphism({x, y}, {u, v})) ||
+                    (findRoot(atomParent, x) == findRoot(atomParent, v) && findAutomorphism({x, y}, {v, u}))) {
+                    merge();
+                    found = true;
+                }
+            }
+            if (!found) representatives.push_back(bond);
+        }
+    }
+
+    numAtomOrbits = flatten(atomParent);
+    numBondOrbits = flatten(bondParent);
+    graph = nullptr;
+}
+
+int Automorphisms::getAtomOrbit(int atom) const {
+    return atomParent[atom];
+}
+
+int Automorphisms::getBondOrbit(int bond) const {
+    return bondParent[bond];
+}
+
+int Automorphisms::getNumAtomOrbits() const {
+    return numAtomOrbits;
+}
+
+int Automorphisms::getNumBondOrbits() const {
+    return numBondOrbits;
+}
+
+bool Automorphisms::isComplete() const {
+    return complete;
+}
+
+/*
+ * Gives the fixed atoms colours of their own (the k-th fixed atom the same
+ * one in every call) and refines the hash's colours from there. Since the
+ * colours are hashes of the same computation, two calls can be compared
+ * colour by colour.
+ */
+void Automorphisms::individualize(std::vector<uint64_t>& colors, const std::vector<int>& fixed) {
+    colors = graph->getColors();
+    for (size_t k = 0; k < fixed.size(); ++k) {
+        colors[fixed[k]] = GraphHash::combine(colors[fixed[k]], ~uint64_t(k));
+    }
+    graph->refine(colors, work);
+}
+
+/*
+ * Searches for an automorphism taking each atom of from to the atom of to
+ * in the same position, leaving it in sigma. Both sides are refined with
+ * those atoms individualized, and the atoms are then matched in breadth-first
+ * order, so each atom only has to be tried against the neighbours of its
+ * parent's image that have its colour.
+ */
+bool Automorphisms::findAutomorphism(const std::vector<int>& from, const std::vector<int>& to) {
+    individualize(fromColors, from);
+    individualize(toColors, to);
+    sortedColors = fromColors;
+    nextColors = toColors;
+    std::sort(sortedColors.begin(), sortedColors.end());
+    std::sort(nextColors.begin(), nextColors.end());
+    if (sortedColors != nextColors) return false;
+
+    // matching order, starting from the first fixed atom
+    order.clear();
+    parent.assign(natoms, -2); // -2 marks an atom not yet ordered
+    for (int i = -1; i < natoms; ++i) {
+        int root = i == -1 ? from[0] : i;
+        if (parent[root] != -2) continue;
+        parent[root] = -1;
+        size_t head = order.size();
+        order.push_back(root);
+        for (; head < order.size(); ++head) {
+            int v = order[head];
+            for (int k = adjStart[v]; k < adjStart[v + 1]; ++k) {
+                if (parent[adjAtom[k]] != -2) continue;
+                parent[adjAtom[k]] = v;
+                order.push_back(adjAtom[k]);
+            }
+        }
+    }
+
+    sigma.assign(natoms, -1);
+    reverse.assign(natoms, -1);
+    next.assign(natoms, 0);
+    auto feasible = [&](int v, int t) {
+        if (fromColors[v] != toColors[t] || reverse[t] != -1) return false;
+        for (int k = adjStart[v]; k < adjStart[v + 1]; ++k) {
+            int u = sigma[adjAtom[k]];
+            if (u == -1) continue;
+            int bond = bondBetween(u, t);
+            if (bond == -1 || bondOrder[bond] != bondOrder[adjBond[k]]) return false;
+        }
+        for (int k = adjStart[t]; k < adjStart[t + 1]; ++k) {
+            int u = reverse[adjAtom[k]];
+            if (u != -1 && bondBetween(v, u) == -1) return false;
+        }
+        return true;
+    };
+
+    long steps = 0, maxSteps = long(SEARCH_STEPS_PER_ATOM) * natoms + 1000;
+    int depth = 0;
+    while (depth >= 0 && depth < natoms) {
+        if (++steps > maxSteps) {
+            complete = false;
+            return false;
+        }
+        int v = order[depth];
+        if (sigma[v] != -1) { // retrying this atom: undo its previous image
+            reverse[sigma[v]] = -1;
+            sigma[v] = -1;
+        }
+        int first = 0, last = natoms;
+        if (parent[v] != -1) {
+            first = adjStart[sigma[parent[v]]];
+            last = adjStart[sigma[parent[v]] + 1];
+        }
+        bool matched = false;
+        while (first + next[depth] < last) {
+            int k = first + next[depth]++;
+            int t = parent[v] != -1 ? adjAtom[k] : k;
+            if (feasible(v, t)) {
+                sigma[v] = t;
+                reverse[t] = v;
+                matched = true;
+                break;
+            }
+        }
+        if (matched) {
+            depth++;
+            if (depth < natoms) next[depth] = 0;
+        } else {
+            depth--;
+        }
+    }
+    return depth == natoms && isAutomorphism();
+}
+
+/*
+ * Checks sigma against the graph itself, so that a colour collision can
+ * never merge atoms that are not equivalent.
+ */
+bool Automorphisms::isAutomorphism() const {
+    for (int i = 0; i < natoms; ++i) {
+        if (labels[i] != labels[sigma[i]]) return false;
+    }
+    for (int i = 0; i < nbonds; ++i) {
+        int image = bondBetween(sigma[bondAtoms[2 * i]], sigma[bondAtoms[2 * i + 1]]);
+        if (image == -1 || bondOrder[image] != bondOrder[i]) return false;
+    }
+    return true;
+}
+
+/*
+ * Merges every atom and bond with its image under sigma.
+ */
+void Automorphisms::merge() {
+    for (int i = 0; i < natoms; ++i) unite(atomParent, i, sigma[i]);
+    for (int i = 0; i < nbonds; ++i) {
+        unite(bondParent, i, bondBetween(sigma[bondAtoms[2 * i]], sigma[bondAtoms[2 * i + 1]]));
+    }
+}
+
+int Automorphisms::bondBetween(int a, int b) const {
+    for (int k = adjStart[a]; k < adjStart[a + 1]; ++k) {
+        if (adjAtom[k] == b) return adjBond[k];
+    }
+    return -1;
+}
+
+static int findRoot(std::vector<int>& parent, int x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+// the lower index becomes the root, so roots are orbit representatives
+static void unite(std::vector<int>& parent, int a, int b) {
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if (a < b) {
+        parent[b] = a;
+    } else if (b < a) {
+        parent[a] = b;
+    }
+}
+
+// points every element straight at its root and returns the number of roots
+static int flatten(std::vector<int>& parent) {
+    int roots = 0;
+    for (size_t i = 0; i < parent.size(); ++i) {
+        parent[i] = findRoot(parent, i);
+        roots += parent[i] == (int) i;
+    }
+    return roots;
+}
@@ -0,0 +1,140 @@
+/**
+ * File: automorphisms.h
+ * ---------------------
+ * This file contains the interface for the Automorphisms class.
+ * Automorphisms finds the symmetry of a Molecule's labelled graph
+ * (element, charge, isotope and hydrogen count on the atoms, order on
+ * the bonds): which atoms, and which bonds, can be mapped onto each
+ * other by a permutation that preserves the whole graph. Such atoms
+ * or bonds form an orbit, and any question about one member (is this
+ * a good bond to cut?) has the same answer for all of them.
+ *
+ * Candidate atoms are first grouped by the colours of the molecule's
+ * GraphHash, whose refinement never separates equivalent atoms. Within a colour class, two atoms are
+ * proven equivalent by individualizing them, refining again, and
+ * searching for a matching permutation, which is checked against every
+ * bond before it is used. Each permutation found merges orbits with a
+ * union-find. A search that takes too long is abandoned and the atoms
+ * are left apart, so orbits are never too large, only too small.
+ */
+
+#ifndef _automorphisms_h
+#define _automorphisms_h
+
+#include <cstdint>
+#include <vector>
+#include "graphhash.h"
+#include "molecule.h"
+
+class Automorphisms {
+public:
+    /**
+     * Constructor: Automorphisms
+     * Usage: Automorphisms symmetry;
+     * ------------------------------
+     * Initializes the symmetry of an empty graph.
+     */
+    Automorphisms();
+
+    /**
+     * Constructor: Automorphisms
+     * Parameters: mol
+     * Usage: Automorphisms symmetry(mol);
+     * -----------------------------------
+     * Finds the atom and bond orbits of the molecule.
+     */
+    Automorphisms(const Molecule& mol);
+
+    /**
+     * Function: compute
+     * Parameters: mol
+     * Usage: symmetry.compute(mol);
+     * -----------------------------
+     * Finds the atom and bond orbits of the molecule, replacing the results
+     * of any previous call. Scratch space is kept between calls.
+     */
+    void compute(const Molecule& mol);
+
+    /**
+     * Function: compute
+     * Parameters: mol, hash
+     * Usage: symmetry.compute(mol, hash);
+     * -----------------------------------
+     * As above, starting from the molecule's hash, already computed, instead
+     * of hashing it again.
+     */
+    void compute(const Molecule& mol, const GraphHash& hash);
+
+    /**
+     * Function: getAtomOrbit
+     * Parameters: atom
+     * Usage: int orbit = symmetry.getAtomOrbit(atom);
+     * -----------------------------------------------
+     * Returns the lowest-numbered atom equivalent to the given atom (by index),
+     * which is the atom itself if it is the representative of its orbit.
+     */
+    int getAtomOrbit(int atom) const;
+
+    /**
+     * Function: getBondOrbit
+     * Parameters: bond
+     * Usage: int orbit = symmetry.getBondOrbit(bond);
+     * -----------------------------------------------
+     * Returns the lowest-numbered bond equivalent to the given bond (by index).
+     */
+    int getBondOrbit(int bond) const;
+
+    /**
+     * Function: getNumAtomOrbits
+     * Usage: int n = symmetry.getNumAtomOrbits();
+     * -------------------------------------------
+     * Returns the number of atom orbits; equal to the number of atoms when
+     * the molecule has no symmetry.
+     */
+    int getNumAtomOrbits() const;
+
+    /**
+     * Function: getNumBondOrbits
+     * Usage: int n = symmetry.getNumBondOrbits();
+     * -------------------------------------------
+     * Returns the number of bond orbits.
+     */
+    int getNumBondOrbits() const;
+
+    /**
+     * Function: isComplete
+     * Usage: if (symmetry.isComplete()) {...}
+     * ---------------------------------------
+     * Returns false if a search was abandoned, in which case some orbits may
+     * be split into several smaller ones.
+     */
+    bool isComplete() const;
+
+private:
+    // labelled graph in compressed adjacency form
+    int natoms, nbonds;
+    std::vector<uint64_t> labels;
+    std::vector<int> adjStart, adjAtom, adjBond;
+    std::vector<int> bondAtoms, bondOrder; // two atoms per bond, one order per bond
+
+    // results: union-find forests whose roots are the lowest index of each orbit
+    std::vector<int> atomParent, bondParent;
+    int numAtomOrbits, numBondOrbits;
+    bool complete;
+
+    // the hash refinement starts from: the caller's, or ownHash (valid during compute)
+    const GraphHash* graph;
+    GraphHash ownHash;
+
+    // scratch space for refinement and search
+    std::vector<uint64_t> fromColors, toColors, nextColors, sortedColors, work;
+    std::vector<int> sigma, reverse, order, parent, next, members;
+
+    void individualize(std::vector<uint64_t>& colors, const std::vector<int>& fixed);
+    bool findAutomorphism(const std::vector<int>& from, const std::vector<int>& to);
+    bool isAutomorphism() const;
+    void merge();
+    int bondBetween(int a, int b) const;
+};
+
+#endif
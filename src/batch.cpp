@@ -0,0 +1,595 @@
+/**
+ * File: batch.cpp
+ * ---------------
+ * This file contains the implementation for the batch interface.
+ * Documentation for each function can be found in the batch.h file.
+ */
+
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include "arena.h"
+#include "checkpoint.h"
+#include "dedupset.h"
+#include "scheduler.h"
+#include "smilesindex.h"
+#include "trace.h"
+#include "batch.h"
+
+// a line of input and, once processed, its line of output
+struct BatchRecord {
+    long line;
+    std::string smiles;
+    std::string result;
+    bool rejected;
+    bool duplicate;
+    GraphHash graph;      // kept between the two passes when deduplicating
+    std::string exported; // the molecule's graph, when exporting
+    std::string descriptors;
+};
+
+// state kept by each worker thread and reused for every molecule it processes
+struct BatchWorker {
+    MolArena arena;
+    Molecule mol;
+    MolGraph graph;
+    DescriptorEngine engine;
+    MolDescriptors descriptors;
+    std::vector<int> clusters;
+    const BatchOptions& options;
+
+    BatchWorker(const BatchOptions& settings, SpectrumCache& cache, const ElementTable& elements) :
+        mol(&arena), graph(settings.backend, &cache), engine(elements), options(settings) {}
+};
+
+// helper function declarations
+static bool parsePositive(const char* text, int& value);
+static bool parseRate(const char* text, double& value);
+static int estimateAtoms(const std::string& smiles, SmilesIndex& index);
+static bool readChunk(std::istream& input, int chunkSize, long lastLine, long& lineNumber,
+                      std::vector<BatchRecord>& records);
+static std::string checkpointSettings(const BatchOptions& options);
+static bool openOutput(std::ofstream& stream, const std::string& path, bool resuming, long bytes);
+static bool parseRecord(BatchRecord& record, BatchWorker& worker);
+static void claimRecord(BatchRecord& record, BatchWorker& worker, DedupSet& seen, bool remember, bool split);
+static void resolveRecord(BatchRecord& record, const DedupSet& seen);
+static void processRecord(BatchRecord& record, BatchWorker& worker);
+static void splitRecord(BatchRecord& record, BatchWorker& worker, const GraphHash* graph);
+static void rejectRecord(BatchRecord& record, const SmilesError& problem);
+static void describeRecord(BatchRecord& record, BatchWorker& worker, bool converted);
+
+bool parseBatchOptions(int argc, char** argv, BatchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string flag = argv[i];
+        if (flag == "--resume") { // the only option without a value
+            options.resume = true;
+            continue;
+        }
+        if (i + 1 == argc) {
+            std::cerr << "Missing value for " << flag << std::endl;
+            return false;
+        }
+        const char* value = argv[++i];
+        if (flag == "--input") {
+            options.inputPath = value;
+        } else if (flag == "--output") {
+            options.outputPath = value;
+        } else if (flag == "--rejects") {
+            options.rejectsPath = value;
+        } else if (flag == "--export") {
+            options.exportPath = value;
+        } else if (flag == "--export-format") {
+            std::string format = value;
+            if (format == "mm") {
+                options.exportFormat = MatrixMarketExport;
+            } else if (format == "edges") {
+                options.exportFormat = EdgeListExport;
+            } else if (format == "csr") {
+                options.exportFormat = CsrExport;
+            } else {
+                std::cerr << "Unknown export format: " << format << std::endl;
+                return false;
+            }
+        } else if (flag == "--descriptors") {
+            options.descriptorsPath = value;
+        } else if (flag == "--elements") {
+            options.elementsPath = value;
+        } else if (flag == "--checkpoint") {
+            options.checkpointPath = value;
+        } else if (flag == "--trace") {
+            options.tracePath = value;
+        } else if (flag == "--trace-rate") {
+            if (!parseRate(value, options.traceRate)) {
+                std::cerr << "Invalid value for " << flag << ": " << value << std::endl;
+                return false;
+            }
+        } else if (flag == "--backend") {
+            std::string backend = value;
+            if (backend == "spectral") {
+                options.backend = SpectralBackend;
+            } else if (backend == "multilevel") {
+                options.backend = MultilevelBackend;
+            } else {
+                std::cerr << "Unknown backend: " << backend << std::endl;
+                return false;
+            }
+        } else if (flag == "--threads" || flag == "--large-atoms" || flag == "--chunk" || flag == "--dedup" ||
+                   flag == "--shard" || flag == "--checkpoint-every") {
+            int number;
+            if (!parsePositive(value, number) || (number == 0 && flag != "--threads" && flag != "--dedup")) {
+                std::cerr << "Invalid value for " << flag << ": " << value << std::endl;
+                return false;
+            }
+            if (flag == "--threads") options.threads = number;
+            if (flag == "--large-atoms") options.largeMolecule = number;
+            if (flag == "--chunk") options.chunkSize = number;
+            if (flag == "--dedup") options.dedupCapacity = number;
+            if (flag == "--shard") options.shardSize = number;
+            if (flag == "--checkpoint-every") options.checkpointInterval = number;
+        } else {
+            std::cerr << "Unknown option: " << flag << std::endl;
+            return false;
+        }
+    }
+    const std::string* firstOutput = nullptr;
+    for (const std::string* path : {&options.outputPath, &options.exportPath, &options.descriptorsPath}) {
+        if (firstOutput == nullptr && !path->empty()) firstOutput = path;
+    }
+    if (options.inputPath.empty() || firstOutput == nullptr) {
+        std::cerr << "--input and at least one of --output, --export and --descriptors are required." << std::endl;
+        return false;
+    }
+    if (options.rejectsPath.empty()) options.rejectsPath = *firstOutput + ".rejects";
+    if (options.resume && options.checkpointPath.empty()) {
+        std::cerr << "--resume needs --checkpoint." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void printBatchUsage() {
+    std::cerr << "Usage: RetroCHEM --input FILE [--output FILE] [--export FILE] [--descriptors FILE] [options]" << std::endl;
+    std::cerr << "  --rejects FILE       where malformed SMILES are listed (default: OUTPUT.rejects)" << std::endl;
+    std::cerr << "  --threads N          worker threads (default: one per core)" << std::endl;
+    std::cerr << "  --large-atoms N      molecules this large get a multithreaded eigensolve (spectral, with OpenBLAS or MKL; default: 300)" << std::endl;
+    std::cerr << "  --backend NAME       spectral or multilevel (default: spectral)" << std::endl;
+    std::cerr << "  --chunk N            molecules read per round (default: 4096)" << std::endl;
+    std::cerr << "  --trace FILE         write a Chrome trace-event JSON trace of sampled molecules" << std::endl;
+    std::cerr << "  --trace-rate R       fraction of molecules traced, above 0 and at most 1 (default: 1)" << std::endl;
+    std::cerr << "  --export FILE        also write every molecule's graph in a sparse format" << std::endl;
+    std::cerr << "  --export-format F    mm (Matrix Market), edges (edge list) or csr (binary shards; default: mm)" << std::endl;
+    std::cerr << "  --shard N            molecules per binary CSR shard (default: 100000)" << std::endl;
+    std::cerr << "  --descriptors FILE   also write formula, masses, charge and ring counts of every molecule" << std::endl;
+    std::cerr << "  --elements FILE      periodic table for descriptors (default: res/periodictable.csv)" << std::endl;
+    std::cerr << "  --checkpoint FILE    record progress in FILE so that the run can be resumed" << std::endl;
+    std::cerr << "  --checkpoint-every S seconds between checkpoints (default: 60)" << std::endl;
+    std::cerr << "  --resume             continue from the checkpoint instead of starting over" << std::endl;
+    std::cerr << "  --dedup N            process each structure once, remembering up to N of them (1-2 KB each)" << std::endl;
+    std::cerr << "Run without arguments for the interactive menu." << std::endl;
+}
+
+int runBatch(const BatchOptions& options) {
+    std::ifstream input(options.inputPath);
+    if (!input) {
+        std::cerr << "Could not open " << options.inputPath << std::endl;
+        return 1;
+    }
+
+    // pick up the checkpoint, if resuming from one
+    BatchCheckpoint checkpoint;
+    checkpoint.settings = checkpointSettings(options);
+    bool resuming = false;
+    if (options.resume) {
+        BatchCheckpoint saved;
+        if (readCheckpoint(options.checkpointPath, saved)) {
+            if (saved.settings != checkpoint.settings) {
+                std::cerr << options.checkpointPath << " was written by a run with other options." << std::endl;
+                return 1;
+            }
+            checkpoint = saved;
+            resuming = true;
+            std::cerr << "Resuming after line " << checkpoint.line << "." << std::endl;
+        } else if (std::ifstream(options.checkpointPath)) {
+            std::cerr << options.checkpointPath << " is not a valid checkpoint." << std::endl;
+            return 1;
+        } else {
+            std::cerr << "No checkpoint in " << options.checkpointPath << "; starting from the beginning." << std::endl;
+        }
+    }
+
+    std::ofstream output;
+    if (!options.outputPath.empty() &&
+        !openOutput(output, options.outputPath, resuming, checkpoint.outputBytes)) {
+        return 1;
+    }
+    std::unique_ptr<GraphWriter> exporter;
+    if (!options.exportPath.empty()) {
+        exporter.reset(new GraphWriter(options.exportPath, options.exportFormat, options.shardSize));
+        if (resuming ? !exporter->resume(checkpoint.exported) : !exporter->open()) {
+            std::cerr << "Could not " << (resuming ? "resume " : "write ") << options.exportPath << std::endl;
+            return 1;
+        }
+    }
+    std::ofstream descriptors;
+    ElementTable elements;
+    if (!options.descriptorsPath.empty()) {
+        if (!elements.load(options.elementsPath)) {
+            std::cerr << "Could not read the periodic table from " << options.elementsPath << std::endl;
+            return 1;
+        }
+        if (!openOutput(descriptors, options.descriptorsPath, resuming, checkpoint.descriptorsBytes)) return 1;
+    }
+    std::ofstream rejects;
+    if (!openOutput(rejects, options.rejectsPath, resuming, checkpoint.rejectsBytes)) return 1;
+
+    // the multilevel backend makes no BLAS calls for a large lane to spread over the cores
+    int largeMolecule = options.backend == MultilevelBackend ? INT_MAX : options.largeMolecule;
+    BatchScheduler scheduler(options.threads, largeMolecule);
+    SpectrumCache cache;
+    std::vector<std::unique_ptr<BatchWorker>> workers;
+    for (int i = 0; i < scheduler.getNumContexts(); ++i) {
+        workers.emplace_back(new BatchWorker(options, cache, elements));
+    }
+    std::vector<BatchRecord> records;
+    SmilesIndex sizing; // only sizeOf uses it, on this thread
+    std::unique_ptr<DedupSet> seen;
+    if (options.dedupCapacity > 0) seen.reset(new DedupSet(options.dedupCapacity));
+    if (seen && resuming) { // claim the structures before the checkpoint again, without processing them
+        long prefixLine = 0;
+        bool more = true;
+        while (more) {
+            more = readChunk(input, options.chunkSize, checkpoint.line, prefixLine, records);
+            bool remember = seen->hasRoom(records.size());
+            scheduler.run(records.size(), [&](int job) { return estimateAtoms(records[job].smiles, sizing); },
+                          [&](int job, int worker) {
+                claimRecord(records[job], *workers[worker], *seen, remember, false);
+            });
+        }
+        input.clear();
+    }
+    if (resuming) input.seekg(checkpoint.inputOffset);
+    if (!options.tracePath.empty() && !startTrace(options.tracePath, options.traceRate)) {
+        std::cerr << "Could not write " << options.tracePath << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<CheckpointWriter> checkpoints;
+    if (!options.checkpointPath.empty()) checkpoints.reset(new CheckpointWriter(options.checkpointPath));
+    long lineNumber = checkpoint.line, processed = checkpoint.processed;
+    long rejected = checkpoint.rejected, duplicates = checkpoint.duplicates;
+    std::vector<std::string> files;
+    auto start = std::chrono::steady_clock::now();
+    auto nextCheckpoint = start + std::chrono::seconds(options.checkpointInterval);
+    bool more = true;
+    while (more) {
+        more = readChunk(input, options.chunkSize, LONG_MAX, lineNumber, records);
+        auto sizeOf = [&](int job) { return estimateAtoms(records[job].smiles, sizing); };
+        if (seen) {
+            // new structures are only remembered in chunks that are sure to fit, so which
+            // ones are never depends on timing; after all claims, the first line wins
+            bool remember = seen->hasRoom(records.size());
+            scheduler.run(records.size(), sizeOf, [&](int job, int worker) {
+                claimRecord(records[job], *workers[worker], *seen, remember, true);
+            });
+            scheduler.run(records.size(), sizeOf, [&](int job, int) { resolveRecord(records[job], *seen); });
+        } else {
+            scheduler.run(records.size(), sizeOf,
+                          [&](int job, int worker) { processRecord(records[job], *workers[worker]); });
+        }
+        for (const BatchRecord& record : records) {
+            if (record.rejected) {
+                rejects << record.result << '\n';
+            } else {
+                if (output.is_open()) output << record.result << '\n';
+                if (exporter && !record.duplicate) exporter->write(record.exported);
+                if (descriptors.is_open()) descriptors << record.descriptors << '\n';
+            }
+            rejected += record.rejected;
+            duplicates += record.duplicate;
+        }
+        processed += records.size();
+        if (exporter && exporter->hasFailed()) { // a full disk should not cost the rest of the run
+            std::cerr << "Could not write " << options.exportPath << std::endl;
+            return 1;
+        }
+        if (isTracing() && !flushTrace()) { // so a killed run keeps its trace up to here
+            std::cerr << "Could not write " << options.tracePath << std::endl;
+            return 1;
+        }
+
+        // everything up to here is written, so it is a consistent point to resume from
+        if (checkpoints && more && std::chrono::steady_clock::now() >= nextCheckpoint) {
+            output.flush();
+            descriptors.flush();
+            rejects.flush();
+            checkpoint.inputOffset = input.tellg();
+            checkpoint.line = lineNumber;
+            checkpoint.processed = processed;
+            checkpoint.rejected = rejected;
+            checkpoint.duplicates = duplicates;
+            checkpoint.outputBytes = output.is_open() ? (long) output.tellp() : 0;
+            checkpoint.descriptorsBytes = descriptors.is_open() ? (long) descriptors.tellp() : 0;
+            checkpoint.rejectsBytes = rejects.tellp();
+            // the writer thread syncs these before the checkpoint that counts their bytes
+            files.clear();
+            if (output.is_open()) files.push_back(options.outputPath);
+            if (descriptors.is_open()) files.push_back(options.descriptorsPath);
+            files.push_back(options.rejectsPath);
+            if (exporter) {
+                checkpoint.exported = exporter->getPosition();
+                exporter->listFiles(files);
+            }
+            checkpoints->post(checkpoint, files);
+            nextCheckpoint = std::chrono::steady_clock::now() + std::chrono::seconds(options.checkpointInterval);
+        }
+    }
+    output.flush();
+    descriptors.flush();
+    rejects.flush();
+    if (exporter && !exporter->close()) {
+        std::cerr << "Could not write " << options.exportPath << std::endl;
+        return 1;
+    }
+    if (isTracing() && !stopTrace()) {
+        std::cerr << "Could not write " << options.tracePath << std::endl;
+        return 1;
+    }
+    if (checkpoints && !checkpoints->finish()) {
+        std::cerr << "Could not write " << options.checkpointPath << std::endl;
+        return 1;
+    }
+    bool written = output && descriptors && rejects;
+    if (checkpoints && written) std::remove(options.checkpointPath.c_str()); // the run is complete
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cerr << "Processed " << processed << " molecules in " << elapsed.count() << " s using "
+              << scheduler.getNumWorkers() << " threads (" << cache.getHits()
+              << " spectra reused, " << rejected << " rejected, " << duplicates
+              << " duplicates)." << std::endl;
+    return written ? 0 : 1;
+}
+
+static bool parsePositive(const char* text, int& value) {
+    char* end;
+    long number = std::strtol(text, &end, 10);
+    if (*text == '\0' || *end != '\0' || number < 0 || number > 1000000000) return false;
+    value = number;
+    return true;
+}
+
+static bool parseRate(const char* text, double& value) {
+    char* end;
+    double number = std::strtod(text, &end);
+    if (*text == '\0' || *end != '\0' || !(number > 0 && number <= 1)) return false;
+    value = number;
+    return true;
+}
+
+/*
+ * Estimates the number of atoms from the structural index: every letter
+ * before the first whitespace (after which comes the name, as in
+ * parseSmiles) is about one atom (two-letter elements and bracket hydrogens
+ * count a little high). Good enough to pick a lane for the molecule without
+ * parsing it. The index is rebuilt in place, so one serves every record.
+ */
+static int estimateAtoms(const std::string& smiles, SmilesIndex& index) {
+    index.build(smiles.data(), smiles.size());
+    return index.count(SmilesAtom, index.find(SmilesWhitespace, 0));
+}
+
+/*
+ * Parses the record into the worker's molecule, rejecting it if the SMILES is
+ * malformed. The previous molecule is released in bulk first (also if it
+ * failed part way). The molecule, like the rest of the worker (its graph's
+ * matrices, ring perception, partitioner and descriptor engine) and each
+ * thread's scratch space for hashing and table lookups, keeps its storage
+ * from one record to the next and only grows for a record larger than any
+ * before. What still allocates for every record is the record itself: its
+ * input line, the output, export and descriptor lines it hands to the main
+ * thread and, when deduplicating, its graph hash. So do Armadillo's workspace
+ * inside eig_sym and MolGraph's Stanford Vectors of results, if Vector::clear
+ * frees its storage.
+ */
+static bool parseRecord(BatchRecord& record, BatchWorker& worker) {
+    worker.mol.clear();
+    worker.arena.reset();
+    SmilesError problem;
+    problem.line = record.line;
+    if (worker.mol.parseSmiles(record.smiles.data(), record.smiles.size(), problem)) return true;
+    rejectRecord(record, problem);
+    return false;
+}
+
+/*
+ * First pass when deduplicating: parses the molecule, hashes its graph, and
+ * claims the structure for this line. If split is true and no earlier line
+ * holds the structure, the molecule is processed right away, while it is
+ * still parsed and hashed; resolveRecord later turns it into a duplicate
+ * in the rare case that an earlier line of the same chunk claims it after.
+ * With remember false, new structures are not added to the set.
+ */
+static void claimRecord(BatchRecord& record, BatchWorker& worker, DedupSet& seen, bool remember, bool split) {
+    TraceMolecule traced(record.line);
+    try {
+        if (!parseRecord(record, worker)) return;
+        traced.setCounts(worker.mol.getAtoms().size(), worker.mol.getBonds().size());
+        long first;
+        {
+            TraceSpan span("dedup");
+            record.graph.compute(worker.mol);
+            first = seen.claim(record.graph, record.line, remember);
+            span.setArg("first", first);
+        }
+        if (split && first == record.line) splitRecord(record, worker, &record.graph);
+    } catch (const std::exception& e) {
+        SmilesError problem;
+        problem.line = record.line;
+        problem.reason = e.what();
+        rejectRecord(record, problem);
+    }
+}
+
+/*
+ * Second pass when deduplicating: once every line of the chunk has made its
+ * claim, points a structure that an earlier line holds back to that line.
+ */
+static void resolveRecord(BatchRecord& record, const DedupSet& seen) {
+    if (record.rejected) return;
+    long first = seen.lookup(record.graph);
+    if (first == -1 || first == record.line) return; // not remembered, or the first
+    record.result = std::to_string(record.line) + '\t' + std::to_string(record.graph.getNumAtoms()) + '\t' +
+                    std::to_string(record.graph.getNumBonds()) + "\t=" + std::to_string(first);
+    record.descriptors = std::to_string(record.line) + "\t=" + std::to_string(first);
+    record.exported.clear();
+    record.duplicate = true;
+}
+
+/*
+ * Parses and splits one molecule when not deduplicating. Nothing escapes:
+ * a failure in one record is rejected and never stops the run.
+ */
+static void processRecord(BatchRecord& record, BatchWorker& worker) {
+    TraceMolecule traced(record.line);
+    try {
+        if (!parseRecord(record, worker)) return;
+        traced.setCounts(worker.mol.getAtoms().size(), worker.mol.getBonds().size());
+        splitRecord(record, worker, nullptr);
+    } catch (const std::exception& e) {
+        SmilesError problem;
+        problem.line = record.line;
+        problem.reason = e.what();
+        rejectRecord(record, problem);
+    }
+}
+
+/*
+ * Splits the molecule parsed into the worker, filling in the record's output
+ * line, exported graph and descriptors. graph is the molecule's hash if it
+ * has one already, or null.
+ */
+static void splitRecord(BatchRecord& record, BatchWorker& worker, const GraphHash* graph) {
+    Molecule& mol = worker.mol;
+    if (!worker.options.exportPath.empty()) {
+        TraceSpan span("export");
+        record.exported.clear();
+        appendGraph(mol, record.line, worker.options.exportFormat, record.exported);
+    }
+    bool split = !worker.options.outputPath.empty(); // otherwise no matrices at all
+    if (split) {
+        if (graph != nullptr) {
+            worker.graph.moleculeToGraph(mol, *graph);
+        } else {
+            worker.graph.moleculeToGraph(mol);
+        }
+    }
+    if (!worker.options.descriptorsPath.empty()) describeRecord(record, worker, split);
+    if (!split) return;
+    worker.graph.getClusters(worker.clusters);
+    std::string& result = record.result;
+    result.reserve(32 + worker.clusters.size());
+    result = std::to_string(record.line);
+    result += '\t';
+    result += std::to_string(mol.getAtoms().size());
+    result += '\t';
+    result += std::to_string(mol.getBonds().size());
+    result += '\t';
+    for (int cluster : worker.clusters) result += char('0' + cluster);
+}
+
+/*
+ * Marks the record rejected, with a reject file line of the form
+ *     <line number> TAB <byte offset> TAB <reason> TAB <input line>
+ */
+static void rejectRecord(BatchRecord& record, const SmilesError& problem) {
+    std::ostringstream line;
+    line << problem.line << '\t' << problem.offset << '\t' << problem.reason << '\t' << record.smiles;
+    record.result = line.str();
+    record.rejected = true;
+}
+
+/*
+ * Fills in the record's line of descriptors from the worker's molecule,
+ * reusing the rings of its graph if the molecule was converted to one.
+ */
+static void describeRecord(BatchRecord& record, BatchWorker& worker, bool converted) {
+    TraceSpan span("descriptors");
+    MolDescriptors& values = worker.descriptors;
+    if (converted) {
+        worker.engine.compute(worker.mol, worker.graph.getRings(), values);
+    } else {
+        worker.engine.compute(worker.mol, values);
+    }
+    char numbers[128];
+    std::snprintf(numbers, sizeof(numbers), "%.5f\t%.3f\t%d\t%d\t%d\t%d\t%d", values.exactMass,
+                  values.averageMass, values.heavyAtoms, values.charge, values.rings, values.ringSystems,
+                  values.aromaticRings);
+    std::string& line = record.descriptors;
+    line = std::to_string(record.line);
+    line += '\t';
+    line += values.formula.empty() ? "-" : values.formula;
+    line += '\t';
+    line += numbers;
+}
+
+/*
+ * Reads the next chunk of non-blank lines, up to and including line lastLine,
+ * into records, numbering them on from lineNumber. Returns false once the
+ * input or lastLine has been reached; records may still hold a last chunk.
+ */
+static bool readChunk(std::istream& input, int chunkSize, long lastLine, long& lineNumber,
+                      std::vector<BatchRecord>& records) {
+    records.clear();
+    std::string line;
+    while ((int) records.size() < chunkSize) {
+        if (lineNumber >= lastLine || !std::getline(input, line)) return false;
+        lineNumber++;
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue; // blank line
+        records.push_back({lineNumber, line, "", false, false, GraphHash(), "", ""});
+    }
+    return true;
+}
+
+/*
+ * The options that decide what a run writes where; a checkpoint can only be
+ * resumed by a run with the same ones. The chunk size is among them because
+ * checkpoints fall on chunk boundaries and the dedup set fills chunk by chunk.
+ */
+static std::string checkpointSettings(const BatchOptions& options) {
+    std::ostringstream settings;
+    settings << "input=" << options.inputPath << " output=" << options.outputPath
+             << " rejects=" << options.rejectsPath << " export=" << options.exportPath
+             << " format=" << options.exportFormat << " shard=" << options.shardSize
+             << " descriptors=" << options.descriptorsPath << " backend=" << options.backend
+             << " elements=" << options.elementsPath << " dedup=" << options.dedupCapacity
+             << " chunk=" << options.chunkSize;
+    return settings.str();
+}
+
+/*
+ * Opens an output file: a new one, or, when resuming, the existing one cut
+ * back to the size recorded in the checkpoint and positioned at its end.
+ */
+static bool openOutput(std::ofstream& stream, const std::string& path, bool resuming, long bytes) {
+    if (!resuming) {
+        stream.open(path);
+    } else {
+        std::error_code problem;
+        std::uintmax_t size = std::filesystem::file_size(path, problem);
+        if (!problem && size >= (std::uintmax_t) bytes) std::filesystem::resize_file(path, bytes, problem);
+        if (!problem && size >= (std::uintmax_t) bytes) {
+            stream.open(path, std::ios::in | std::ios::out);
+            stream.seekp(0, std::ios::end);
+        }
+    }
+    if (!stream.is_open() || !stream) {
+        std::cerr << "Could not " << (resuming ? "resume " : "open ") << path << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,106 @@
+/**
+ * File: batch.h
+ * -------------
+ * This file contains the interface for RetroCHEM's batch mode.
+ * Batch mode reads a file with one SMILES per line (anything after
+ * the first whitespace, such as a name, is ignored), predicts a
+ * retrosynthetic step for every molecule in parallel, and writes one
+ * line per molecule, in input order:
+ *
+ *     <line number> TAB <atoms> TAB <bonds> TAB <cluster of each atom>
+ *
+ * where the clusters are written as a string of 0s and 1s. With --dedup,
+ * a structure that already appeared earlier in the input (in any atom
+ * order) is not processed again, and its line instead reads
+ *
+ *     <line number> TAB <atoms> TAB <bonds> TAB =<line of first occurrence>
+ *
+ * --dedup N remembers at most N structures, at 1 to 2 KB each for
+ * drug-sized molecules (see dedupset.h), so N bounds its memory. New
+ * structures stop being remembered at the first chunk that might not
+ * fit, which keeps the output the same whatever the thread count.
+ *
+ * With --export, the graph of every molecule processed is also written
+ * in a sparse format (see graphexport.h), in input order. Without
+ * --output, that is all batch mode does, and no matrices are built.
+ *
+ * With --descriptors, a line of molecular descriptors (see descriptors.h)
+ * is written for every molecule, in input order:
+ *
+ *     <line number> TAB <formula> TAB <exact mass> TAB <average mass> TAB
+ *     <heavy atoms> TAB <charge> TAB <rings> TAB <ring systems> TAB <aromatic rings>
+ *
+ * or, for a duplicate, <line number> TAB =<line of first occurrence>.
+ *
+ * Lines that are not valid SMILES do not stop the run; they go to a
+ * reject file as
+ *
+ *     <line number> TAB <byte offset> TAB <reason> TAB <input line>
+ *
+ * With --checkpoint, a long run records how far it has got every so
+ * often (see checkpoint.h), and the same command with --resume added
+ * continues from there, appending to the output files.
+ */
+
+#ifndef _batch_h
+#define _batch_h
+
+#include <string>
+#include "molgraph.h"
+#include "graphexport.h"
+#include "descriptors.h"
+
+/**
+ * Struct: BatchOptions
+ * --------------------
+ * Settings for a batch run, normally taken from the command line.
+ */
+struct BatchOptions {
+    std::string inputPath;                      // --input
+    std::string outputPath;                     // --output (empty: no partitions)
+    std::string rejectsPath;                    // --rejects (default: first output path + ".rejects")
+    int threads = 0;                            // --threads (0: one per core)
+    int largeMolecule = 300;                    // --large-atoms: size of the large-molecule lane
+    PartitionBackend backend = SpectralBackend; // --backend spectral|multilevel
+    int chunkSize = 4096;                       // --chunk: molecules read per round
+    int dedupCapacity = 0;                      // --dedup: distinct structures remembered (0: off)
+    std::string exportPath;                     // --export (empty: no export)
+    ExportFormat exportFormat = MatrixMarketExport; // --export-format mm|edges|csr
+    int shardSize = 100000;                     // --shard: molecules per binary CSR shard
+    std::string descriptorsPath;                // --descriptors (empty: none)
+    std::string elementsPath = "res/periodictable.csv"; // --elements: the periodic table for descriptors
+    std::string checkpointPath;                 // --checkpoint (empty: no checkpoints)
+    int checkpointInterval = 60;                // --checkpoint-every: seconds between checkpoints
+    bool resume = false;                        // --resume: continue from the checkpoint, if any
+    std::string tracePath;                      // --trace (empty: no tracing)
+    double traceRate = 1;                       // --trace-rate: fraction of molecules traced
+};
+
+/**
+ * Function: parseBatchOptions
+ * Parameters: argc, argv, options
+ * Usage: if (parseBatchOptions(argc, argv, options)) {...}
+ * --------------------------------------------------------
+ * Fills options from the command-line arguments. Returns false, after
+ * printing the reason to cerr, if they are not valid.
+ */
+bool parseBatchOptions(int argc, char** argv, BatchOptions& options);
+
+/**
+ * Function: printBatchUsage
+ * Usage: printBatchUsage();
+ * -------------------------
+ * Prints the command-line options of batch mode to cerr.
+ */
+void printBatchUsage();
+
+/**
+ * Function: runBatch
+ * Parameters: options
+ * Usage: int status = runBatch(options);
+ * --------------------------------------
+ * Processes the whole input file and returns the program's exit status.
+ */
+int runBatch(const BatchOptions& options);
+
+#endif
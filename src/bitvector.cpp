@@ -0,0 +1,84 @@
+/**
+ * File: bitvector.cpp
+ * -------------------
+ * This file contains the implementation for the BitVector interface.
+ * Documentation for each method can be found in the bitvector.h file.
+ */
+
+#include "bitvector.h"
+
+BitVector::BitVector() : nbits(0) {}
+
+BitVector::BitVector(size_t size) : words((size + 63) / 64, 0), nbits(size) {}
+
+void BitVector::assign(size_t size) {
+    words.assign((size + 63) / 64, 0);
+    nbits = size;
+}
+
+void BitVector::set(size_t bit) {
+    words[bit / 64] |= uint64_t(1) << (bit % 64);
+}
+
+void BitVector::reset(size_t bit) {
+    words[bit / 64] &= ~(uint64_t(1) << (bit % 64));
+}
+
+bool BitVector::test(size_t bit) const {
+    return (words[bit / 64] >> (bit % 64)) & 1;
+}
+
+size_t BitVector::count() const {
+    size_t total = 0;
+    for (uint64_t word : words) total += countSetBits(word);
+    return total;
+}
+
+bool BitVector::none() const {
+    for (uint64_t word : words) {
+        if (word != 0) return false;
+    }
+    return true;
+}
+
+size_t BitVector::findFirst() const {
+    for (size_t i = 0; i < words.size(); ++i) {
+        if (words[i] != 0) return 64 * i + lowestSetBit(words[i]);
+    }
+    return nbits;
+}
+
+size_t BitVector::findNext(size_t bit) const {
+    bit++;
+    if (bit >= nbits) return nbits;
+    size_t i = bit / 64;
+    uint64_t word = words[i] & (~uint64_t(0) << (bit % 64));
+    while (word == 0) {
+        if (++i == words.size()) return nbits;
+        word = words[i];
+    }
+    return 64 * i + lowestSetBit(word);
+}
+
+size_t BitVector::size() const {
+    return nbits;
+}
+
+BitVector& BitVector::operator^=(const BitVector& other) {
+    for (size_t i = 0; i < words.size(); ++i) words[i] ^= other.words[i];
+    return *this;
+}
+
+BitVector& BitVector::operator&=(const BitVector& other) {
+    for (size_t i = 0; i < words.size(); ++i) words[i] &= other.words[i];
+    return *this;
+}
+
+BitVector& BitVector::operator|=(const BitVector& other) {
+    for (size_t i = 0; i < words.size(); ++i) words[i] |= other.words[i];
+    return *this;
+}
+
+bool BitVector::operator==(const BitVector& other) const {
+    return nbits == other.nbits && words == other.words;
+}
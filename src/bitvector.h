@@ -0,0 +1,168 @@
+/**
+ * File: bitvector.h
+ * -----------------
+ * This file contains the interface for the BitVector class.
+ * A BitVector is a fixed-size set of small integers (atom or bond
+ * indices) packed 64 to a word, so that sets can be combined with
+ * word-wide XOR/AND operations. Cycles are stored this way during
+ * ring perception, where they are added together over GF(2).
+ */
+
+#ifndef _bitvector_h
+#define _bitvector_h
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Function: lowestSetBit
+ * Parameters: word
+ * Usage: int bit = lowestSetBit(word);
+ * ------------------------------------
+ * Returns the index of the lowest set bit of a word that is not zero.
+ */
+inline int lowestSetBit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while (!(word & 1)) {
+        word >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+/**
+ * Function: countSetBits
+ * Parameters: word
+ * Usage: int bits = countSetBits(word);
+ * -------------------------------------
+ * Returns the number of set bits in a word.
+ */
+inline int countSetBits(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(word);
+#else
+    int bits = 0;
+    for (; word != 0; word &= word - 1) bits++;
+    return bits;
+#endif
+}
+
+class BitVector {
+public:
+    /**
+     * Constructor: BitVector
+     * Usage: BitVector bits;
+     * ----------------------
+     * Initializes an empty BitVector that can hold no bits.
+     */
+    BitVector();
+
+    /**
+     * Constructor: BitVector
+     * Parameters: size
+     * Usage: BitVector bits(size);
+     * ----------------------------
+     * Initializes a BitVector that can hold bits 0 through size - 1, all cleared.
+     */
+    BitVector(size_t size);
+
+    /**
+     * Function: assign
+     * Parameters: size
+     * Usage: bits.assign(size);
+     * -------------------------
+     * Resizes the BitVector to hold bits 0 through size - 1 and clears them
+     * all, keeping its storage.
+     */
+    void assign(size_t size);
+
+    /**
+     * Function: set
+     * Parameters: bit
+     * Usage: bits.set(bit);
+     * ---------------------
+     * Sets the given bit.
+     */
+    void set(size_t bit);
+
+    /**
+     * Function: reset
+     * Parameters: bit
+     * Usage: bits.reset(bit);
+     * -----------------------
+     * Clears the given bit.
+     */
+    void reset(size_t bit);
+
+    /**
+     * Function: test
+     * Parameters: bit
+     * Usage: if (bits.test(bit)) {...}
+     * --------------------------------
+     * Returns true if the given bit is set.
+     */
+    bool test(size_t bit) const;
+
+    /**
+     * Function: count
+     * Usage: size_t n = bits.count();
+     * -------------------------------
+     * Returns the number of set bits.
+     */
+    size_t count() const;
+
+    /**
+     * Function: none
+     * Usage: if (bits.none()) {...}
+     * -----------------------------
+     * Returns true if no bit is set.
+     */
+    bool none() const;
+
+    /**
+     * Function: findFirst
+     * Usage: size_t bit = bits.findFirst();
+     * -------------------------------------
+     * Returns the lowest set bit, or size() if no bit is set.
+     */
+    size_t findFirst() const;
+
+    /**
+     * Function: findNext
+     * Parameters: bit
+     * Usage: for (size_t b = bits.findFirst(); b < bits.size(); b = bits.findNext(b)) {...}
+     * -------------------------------------------------------------------------------------
+     * Returns the lowest set bit above the one given, or size() if there is none.
+     */
+    size_t findNext(size_t bit) const;
+
+    /**
+     * Function: size
+     * Usage: size_t n = bits.size();
+     * ------------------------------
+     * Returns the number of bits the BitVector can hold.
+     */
+    size_t size() const;
+
+    /**
+     * Operators: ^=, &=, |=, ==
+     * Usage: cycle ^= other;
+     * ----------------------
+     * Word-wide set operations. Both operands must have the same size.
+     */
+    BitVector& operator^=(const BitVector& other);
+    BitVector& operator&=(const BitVector& other);
+    BitVector& operator|=(const BitVector& other);
+    bool operator==(const BitVector& other) const;
+
+private:
+    std::vector<uint64_t> words;
+    size_t nbits;
+};
+
+#endif
@@ -0,0 +1,35 @@
+/**
+ * File: blasthreads.cpp
+ * ---------------------
+ * This file contains the implementation for the blasthreads interface.
+ * Documentation for each function can be found in the blasthreads.h file.
+ */
+
+#include "blasthreads.h"
+
+/*
+ * The thread controls are declared weak, so they resolve to null unless the
+ * BLAS library the program is linked against actually provides them.
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(_WIN32)
+#define RETROCHEM_WEAK_BLAS
+extern "C" {
+    void openblas_set_num_threads(int threads) __attribute__((weak));
+    int mkl_set_num_threads_local(int threads) __attribute__((weak));
+}
+#endif
+
+bool setBlasThreads(int threads) {
+#ifdef RETROCHEM_WEAK_BLAS
+    if (mkl_set_num_threads_local) {
+        mkl_set_num_threads_local(threads);
+        return true;
+    } else if (openblas_set_num_threads) {
+        openblas_set_num_threads(threads);
+        return true;
+    }
+#else
+    (void) threads;
+#endif
+    return false;
+}
@@ -0,0 +1,26 @@
+/**
+ * File: blasthreads.h
+ * -------------------
+ * This file contains the interface for controlling how many threads
+ * the BLAS/LAPACK library behind Armadillo may use. Armadillo does not
+ * expose this itself, so the calls are forwarded to whichever of
+ * OpenBLAS or MKL the program was linked against; with a reference
+ * BLAS they have no effect.
+ */
+
+#ifndef _blasthreads_h
+#define _blasthreads_h
+
+/**
+ * Function: setBlasThreads
+ * Parameters: threads
+ * Usage: if (setBlasThreads(1)) {...}
+ * -----------------------------------
+ * Limits the number of threads BLAS/LAPACK calls may use. With MKL the
+ * limit applies only to the calling thread; with OpenBLAS it applies to
+ * the whole process. Returns false if the library has no such control,
+ * so that BLAS calls stay single-threaded whatever is asked.
+ */
+bool setBlasThreads(int threads);
+
+#endif
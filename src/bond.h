@@ -6,6 +6,9 @@
  * to a weighted arc/edge on a directed graph.
  */
 
+#ifndef _bond_h
+#define _bond_h
+
 #include <string>
 #include "atom.h"
 
@@ -108,3 +111,5 @@ private:
     int order; // strength/type of the bond
     int stereo; // stereochemical information
 };
+
+#endif
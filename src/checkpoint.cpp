@@ -0,0 +1,127 @@
+/**
+ * File: checkpoint.cpp
+ * --------------------
+ * This file contains the implementation for the checkpoint interface.
+ * Documentation for each function can be found in the checkpoint.h file.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include "checkpoint.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// first line of every checkpoint file
+static const char* CHECKPOINT_HEADER = "RetroCHEM checkpoint 1";
+
+// helper function declarations
+static bool syncPath(const std::string& path);
+
+bool readCheckpoint(const std::string& path, BatchCheckpoint& checkpoint) {
+    std::ifstream input(path);
+    std::string line;
+    if (!std::getline(input, line) || line != CHECKPOINT_HEADER) return false;
+    if (!std::getline(input, checkpoint.settings)) return false;
+    GraphWriter::Position& exported = checkpoint.exported;
+    input >> checkpoint.inputOffset >> checkpoint.line >> checkpoint.processed >> checkpoint.rejected
+          >> checkpoint.duplicates >> checkpoint.outputBytes >> checkpoint.rejectsBytes
+          >> checkpoint.descriptorsBytes >> exported.shards >> exported.molecules >> exported.bytes;
+    return !input.fail();
+}
+
+bool writeCheckpoint(const std::string& path, const BatchCheckpoint& checkpoint) {
+    std::string temporary = path + ".tmp";
+    std::FILE* output = std::fopen(temporary.c_str(), "w");
+    if (output == nullptr) return false;
+    const GraphWriter::Position& exported = checkpoint.exported;
+    std::fprintf(output, "%s\n%s\n%ld %ld\n%ld %ld %ld\n%ld %ld %ld\n%d %ld %ld\n",
+                 CHECKPOINT_HEADER, checkpoint.settings.c_str(), checkpoint.inputOffset, checkpoint.line,
+                 checkpoint.processed, checkpoint.rejected, checkpoint.duplicates, checkpoint.outputBytes,
+                 checkpoint.rejectsBytes, checkpoint.descriptorsBytes, exported.shards, exported.molecules,
+                 exported.bytes);
+    bool written = std::fflush(output) == 0 && !std::ferror(output);
+#if !defined(_WIN32)
+    written = written && fsync(fileno(output)) == 0;
+#endif
+    written = std::fclose(output) == 0 && written;
+    if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) return false;
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    return syncPath(directory.empty() ? "." : directory);
+}
+
+CheckpointWriter::CheckpointWriter(const std::string& file) : path(file) {
+    writer = std::thread(&CheckpointWriter::writerLoop, this);
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    finish();
+}
+
+void CheckpointWriter::post(const BatchCheckpoint& checkpoint, const std::vector<std::string>& files) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        pending = checkpoint;
+        for (const std::string& file : files) {
+            if (std::find(pendingFiles.begin(), pendingFiles.end(), file) == pendingFiles.end()) {
+                pendingFiles.push_back(file);
+            }
+        }
+        hasPending = true;
+    }
+    wake.notify_one();
+}
+
+bool CheckpointWriter::finish() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_one();
+    if (writer.joinable()) writer.join();
+    return !failed;
+}
+
+/*
+ * Waits for checkpoints, syncs their files and writes them, outside the lock
+ * so that posting never waits for the disk. Pending checkpoints are written
+ * before stopping.
+ */
+void CheckpointWriter::writerLoop() {
+    std::unique_lock<std::mutex> guard(lock);
+    std::vector<std::string> files;
+    while (true) {
+        wake.wait(guard, [this] { return hasPending || stopping; });
+        if (!hasPending) return; // stopping, and nothing left to write
+        BatchCheckpoint checkpoint = pending;
+        files.swap(pendingFiles);
+        pendingFiles.clear();
+        hasPending = false;
+        guard.unlock();
+        bool written = true;
+        for (const std::string& file : files) written = written && syncPath(file);
+        written = written && writeCheckpoint(path, checkpoint);
+        guard.lock();
+        failed = failed || !written;
+    }
+}
+
+/*
+ * Flushes a file or directory from the operating system's cache to the disk.
+ * A descriptor opened for reading is enough on the systems that have fsync;
+ * elsewhere this does nothing.
+ */
+static bool syncPath(const std::string& path) {
+#if !defined(_WIN32)
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) return false;
+    bool synced = fsync(descriptor) == 0;
+    return close(descriptor) == 0 && synced;
+#else
+    return true;
+#endif
+}
@@ -0,0 +1,128 @@
+/**
+ * File: checkpoint.h
+ * ------------------
+ * This file contains the interface for batch checkpoints.
+ * Batch mode writes its results strictly in input order, a chunk at a
+ * time, so after any chunk the finished work is exactly the input
+ * before some byte offset, and the output files hold exactly its
+ * results. A checkpoint records that offset, the size of every output
+ * file at that point and the running totals; a resumed run cuts the
+ * files back to those sizes and carries on from the offset.
+ *
+ * Checkpoints are written by a thread of their own, to a temporary
+ * file that is then renamed over the previous checkpoint, so a run
+ * killed at any moment leaves either the old checkpoint or the new one.
+ * The thread first syncs the output files to disk, then the temporary
+ * file before the rename and its directory after it, so that the same
+ * holds if the whole machine goes down: a checkpoint on disk never
+ * counts bytes that are not.
+ */
+
+#ifndef _checkpoint_h
+#define _checkpoint_h
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "graphexport.h"
+
+/**
+ * Struct: BatchCheckpoint
+ * -----------------------
+ * How far a batch run has got. The settings describe the options that
+ * shape the output, and must match for a run to resume from it.
+ */
+struct BatchCheckpoint {
+    std::string settings;
+    long inputOffset = 0;      // byte offset of the first line not yet processed
+    long line = 0;             // number of the last line processed
+    long processed = 0;        // molecules processed, rejected and duplicated so far
+    long rejected = 0;
+    long duplicates = 0;
+    long outputBytes = 0;      // sizes of the output files
+    long rejectsBytes = 0;
+    long descriptorsBytes = 0;
+    GraphWriter::Position exported;
+};
+
+/**
+ * Function: readCheckpoint
+ * Parameters: path, checkpoint
+ * Usage: if (readCheckpoint(path, checkpoint)) {...}
+ * --------------------------------------------------
+ * Reads a checkpoint file. Returns false if it is missing or malformed.
+ */
+bool readCheckpoint(const std::string& path, BatchCheckpoint& checkpoint);
+
+/**
+ * Function: writeCheckpoint
+ * Parameters: path, checkpoint
+ * Usage: if (writeCheckpoint(path, checkpoint)) {...}
+ * ---------------------------------------------------
+ * Writes a checkpoint to path + ".tmp", syncs it to disk and renames it
+ * to path, then syncs the directory. Returns false if any step fails,
+ * leaving any previous checkpoint in place.
+ */
+bool writeCheckpoint(const std::string& path, const BatchCheckpoint& checkpoint);
+
+class CheckpointWriter {
+public:
+    /**
+     * Constructor: CheckpointWriter
+     * Parameters: path
+     * Usage: CheckpointWriter checkpoints(path);
+     * ------------------------------------------
+     * Starts a thread that writes the checkpoints posted to it to path.
+     */
+    CheckpointWriter(const std::string& path);
+
+    /**
+     * Destructor: ~CheckpointWriter
+     * -----------------------------
+     * Writes any checkpoint still waiting and stops the thread.
+     */
+    ~CheckpointWriter();
+
+    /**
+     * Function: post
+     * Parameters: checkpoint, files
+     * Usage: checkpoints.post(checkpoint, files);
+     * -------------------------------------------
+     * Hands a checkpoint to the writer thread and returns at once. The
+     * thread syncs the given files, flushed up to the checkpoint by the
+     * caller, before it writes the checkpoint, and skips the checkpoint if
+     * one of them cannot be synced. If the thread is still busy with an
+     * earlier one, only the latest checkpoint posted meanwhile is written,
+     * after the files of all of them are synced.
+     */
+    void post(const BatchCheckpoint& checkpoint, const std::vector<std::string>& files);
+
+    /**
+     * Function: finish
+     * Usage: if (!checkpoints.finish()) {...}
+     * ---------------------------------------
+     * Writes any checkpoint still waiting and stops the thread. Returns
+     * false if any checkpoint could not be written.
+     */
+    bool finish();
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+private:
+    std::string path;
+    std::mutex lock;
+    std::condition_variable wake;
+    BatchCheckpoint pending;
+    std::vector<std::string> pendingFiles;
+    bool hasPending = false;
+    bool stopping = false;
+    bool failed = false;
+    std::thread writer;
+
+    void writerLoop();
+};
+
+#endif
@@ -0,0 +1,26 @@
+/**
+ * File: cpufeatures.cpp
+ * ---------------------
+ * This file contains the implementation for the cpufeatures interface.
+ * Documentation for each function can be found in the cpufeatures.h file.
+ */
+
+#include "cpufeatures.h"
+
+bool cpuSupportsSSE42() {
+#ifdef RETROCHEM_X86_DISPATCH
+    static const bool supported = __builtin_cpu_supports("sse4.2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+bool cpuSupportsAVX2() {
+#ifdef RETROCHEM_X86_DISPATCH
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,34 @@
+/**
+ * File: cpufeatures.h
+ * -------------------
+ * This file contains the interface for runtime CPU feature detection.
+ * Vectorized code paths are compiled for specific instruction sets
+ * and only selected at runtime when the processor supports them, so
+ * the same binary still runs on older machines.
+ */
+
+#ifndef _cpufeatures_h
+#define _cpufeatures_h
+
+// vectorized paths are only built for x86 with GCC/Clang target attributes
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define RETROCHEM_X86_DISPATCH
+#endif
+
+/**
+ * Function: cpuSupportsSSE42
+ * Usage: if (cpuSupportsSSE42()) {...}
+ * ------------------------------------
+ * Returns true if the processor supports the SSE4.2 instruction set.
+ */
+bool cpuSupportsSSE42();
+
+/**
+ * Function: cpuSupportsAVX2
+ * Usage: if (cpuSupportsAVX2()) {...}
+ * -----------------------------------
+ * Returns true if the processor supports the AVX2 instruction set.
+ */
+bool cpuSupportsAVX2();
+
+#endif
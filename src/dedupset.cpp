@@ -0,0 +1,73 @@
+/**
+ * File: dedupset.cpp
+ * ------------------
+ * This file contains the implementation for the DedupSet interface.
+ * Documentation for each method can be found in the dedupset.h file.
+ */
+
+#include <vector>
+#include "dedupset.h"
+
+DedupSet::DedupSet(size_t maxGraphs) : count(0) {
+    size_t numSlots = 16;
+    while (numSlots < 2 * maxGraphs) numSlots *= 2; // keep the table at most half full
+    slots.reset(new std::atomic<Entry*>[numSlots]);
+    for (size_t i = 0; i < numSlots; ++i) slots[i].store(nullptr, std::memory_order_relaxed);
+    mask = numSlots - 1;
+    capacity = maxGraphs;
+}
+
+DedupSet::~DedupSet() {
+    for (size_t i = 0; i <= mask; ++i) delete slots[i].load(std::memory_order_relaxed);
+}
+
+long DedupSet::claim(const GraphHash& graph, long line, bool remember) {
+    static thread_local std::vector<int> mapping; // kept by the thread between calls
+    Entry* mine = nullptr; // made only when there is an empty slot to put it in
+    size_t slot = graph.getHash() & mask;
+    for (size_t probe = 0; probe <= mask; ++probe, slot = (slot + 1) & mask) {
+        Entry* entry = slots[slot].load(std::memory_order_acquire);
+        if (entry == nullptr) {
+            if (!remember) break;
+            if (count.fetch_add(1) >= capacity) { // full: forget about it
+                count--;
+                break;
+            }
+            if (mine == nullptr) mine = new Entry(graph, line);
+            if (slots[slot].compare_exchange_strong(entry, mine, std::memory_order_acq_rel)) {
+                return line;
+            }
+            count--; // another thread filled the slot first; entry is now theirs
+        }
+        if (entry->graph.getHash() != graph.getHash() || !entry->graph.isomorphism(graph, mapping)) {
+            continue; // a different graph, or a hash collision
+        }
+        long first = entry->first.load();
+        while (line < first && !entry->first.compare_exchange_weak(first, line)) {}
+        delete mine;
+        return line < first ? line : first;
+    }
+    delete mine;
+    return line;
+}
+
+long DedupSet::lookup(const GraphHash& graph) const {
+    static thread_local std::vector<int> mapping;
+    size_t slot = graph.getHash() & mask;
+    for (size_t probe = 0; probe <= mask; ++probe, slot = (slot + 1) & mask) {
+        const Entry* entry = slots[slot].load(std::memory_order_acquire);
+        if (entry == nullptr) break;
+        if (entry->graph.getHash() == graph.getHash() && entry->graph.isomorphism(graph, mapping)) {
+            return entry->first.load();
+        }
+    }
+    return -1;
+}
+
+bool DedupSet::hasRoom(size_t graphs) const {
+    return count + graphs <= capacity;
+}
+
+size_t DedupSet::size() const {
+    return count;
+}
@@ -0,0 +1,110 @@
+/**
+ * File: dedupset.h
+ * ----------------
+ * This file contains the interface for the DedupSet class.
+ * A DedupSet remembers every distinct molecular graph seen in a stream
+ * and the first input line it appeared on, so that repeated structures
+ * can be dropped before the expensive graph and eigensolver stages.
+ * Graphs are keyed by their Weisfeiler-Lehman hash and confirmed with an
+ * isomorphism check, since a few non-isomorphic graphs share a hash.
+ *
+ * The set is lock-free: it is an open-addressing table of atomic slots
+ * that are filled with compare-and-swap, so many worker threads can
+ * insert at once without waiting for each other. The table does not
+ * grow; once it holds its capacity, further new graphs are not
+ * remembered and are simply treated as unique. Which graphs still fit
+ * would then depend on which thread got there first, so a caller that
+ * needs the same answer every run only lets graphs be added in rounds
+ * that hasRoom says will fit.
+ *
+ * Every graph remembered keeps a full GraphHash snapshot: about 150
+ * bytes plus 50 per atom, or 1 to 2 KB for a drug-sized molecule, on
+ * top of 16 to 32 bytes of table per unit of capacity.
+ */
+
+#ifndef _dedupset_h
+#define _dedupset_h
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include "graphhash.h"
+
+class DedupSet {
+public:
+    /**
+     * Constructor: DedupSet
+     * Parameters: capacity
+     * Usage: DedupSet seen(capacity);
+     * -------------------------------
+     * Initializes an empty set that remembers up to capacity distinct graphs.
+     */
+    DedupSet(size_t capacity);
+
+    /**
+     * Destructor: ~DedupSet
+     * Usage: (implicit)
+     * -----------------
+     * Frees the remembered graphs.
+     */
+    ~DedupSet();
+
+    DedupSet(const DedupSet&) = delete;
+    DedupSet& operator=(const DedupSet&) = delete;
+
+    /**
+     * Function: claim
+     * Parameters: graph, line, remember
+     * Usage: long first = seen.claim(graph, line);
+     * --------------------------------------------
+     * Records that the graph appears on the given line and returns the
+     * first (smallest) line it is known to appear on so far. Because the
+     * smallest line always wins, the final answer does not depend on the
+     * order in which threads make their claims. A graph not yet in the set
+     * is only added if remember is true and the set is not full; otherwise
+     * the line itself is returned.
+     */
+    long claim(const GraphHash& graph, long line, bool remember = true);
+
+    /**
+     * Function: lookup
+     * Parameters: graph
+     * Usage: long first = seen.lookup(graph);
+     * ---------------------------------------
+     * Returns the first line the graph appears on, or -1 if it was never
+     * claimed (or did not fit).
+     */
+    long lookup(const GraphHash& graph) const;
+
+    /**
+     * Function: hasRoom
+     * Parameters: graphs
+     * Usage: bool remember = seen.hasRoom(records.size());
+     * ----------------------------------------------------
+     * Returns true if that many more graphs are sure to fit.
+     */
+    bool hasRoom(size_t graphs) const;
+
+    /**
+     * Function: size
+     * Usage: size_t distinct = seen.size();
+     * -------------------------------------
+     * Returns the number of distinct graphs remembered.
+     */
+    size_t size() const;
+
+private:
+    struct Entry {
+        GraphHash graph;
+        std::atomic<long> first;
+
+        Entry(const GraphHash& hash, long line) : graph(hash), first(line) {}
+    };
+
+    std::unique_ptr<std::atomic<Entry*>[]> slots;
+    size_t mask;               // number of slots - 1 (a power of two)
+    size_t capacity;           // entries allowed, at most half the slots
+    std::atomic<size_t> count;
+};
+
+#endif
@@ -0,0 +1,466 @@
+/**
+ * File: descriptors.cpp
+ * ---------------------
+ * This file contains the implementation for the descriptors interface.
+ * Documentation for each method can be found in the descriptors.h file.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include "cpufeatures.h"
+#include "descriptors.h"
+
+#ifdef RETROCHEM_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+// sums table[index[i]] over n indices
+typedef double (*GatherSumFunction)(const double* table, const int32_t* index, size_t n);
+
+// weight[i] = order[i] * sqrt(table[first[i]] * table[second[i]]) * scale over n bonds
+typedef void (*GatherWeightFunction)(const double* table, const int32_t* first, const int32_t* second,
+                                     const int32_t* order, double scale, double* weight, size_t n);
+
+// masses of the most abundant isotope, which the periodic table file does not have
+static const struct { int number; double mass; } MONOISOTOPIC[] = {
+    {1, 1.00782503223}, {3, 7.0160034366}, {5, 11.00930536}, {6, 12.0}, {7, 14.00307400443},
+    {8, 15.99491461957}, {9, 18.99840316273}, {11, 22.9897692820}, {12, 23.985041697},
+    {13, 26.98153853}, {14, 27.97692653465}, {15, 30.97376199842}, {16, 31.9720711744},
+    {17, 34.968852682}, {19, 38.9637064864}, {20, 39.962590863}, {26, 55.93493633},
+    {29, 62.92959772}, {30, 63.92914201}, {33, 74.92159457}, {34, 79.9165218},
+    {35, 78.9183376}, {50, 119.90220163}, {52, 129.906222748}, {53, 126.9044719}
+};
+
+// masses of isotopes commonly written in SMILES; others count as their mass number
+static const struct { int number, isotope; double mass; } ISOTOPES[] = {
+    {1, 2, 2.01410177812}, {1, 3, 3.0160492779}, {6, 11, 11.0114336}, {6, 13, 13.00335483507},
+    {6, 14, 14.0032419884}, {7, 15, 15.00010889888}, {8, 17, 16.99913175650},
+    {8, 18, 17.99915961286}, {9, 18, 18.000938}, {16, 34, 33.967867004},
+    {17, 37, 36.965902602}, {35, 81, 80.9162897}, {53, 125, 124.9046294}, {53, 131, 130.9061263}
+};
+
+// helper function declarations
+static void splitCsvLine(const std::string& line, std::vector<std::string>& fields);
+static int findColumn(const std::vector<std::string>& header, const std::string& name);
+static double isotopeMass(int number, int isotope);
+static int organicNumber(const std::string& symbol);
+static int implicitHydrogens(int number, bool aromatic, int valence);
+static void appendCount(std::string& formula, const std::string& symbol, int count);
+static void appendElement(std::string& formula, const std::string& symbol, int number, int count,
+                          const std::vector<std::pair<int, int>>& isotopes);
+static GatherSumFunction selectGatherSum();
+static GatherWeightFunction selectGatherWeight();
+
+ElementTable::ElementTable() : averageMass(1, 0.0), exactMass(1, 0.0), electronegativity(1, 0.0) {
+    symbols.add("*");
+    std::memset(bySymbol, 0, sizeof(bySymbol));
+}
+
+bool ElementTable::load(const std::string& path) {
+    std::ifstream input(path);
+    if (!input) return false;
+    std::string line;
+    std::vector<std::string> fields;
+    if (!std::getline(input, line)) return false;
+    splitCsvLine(line, fields);
+    int numberColumn = findColumn(fields, "AtomicNumber");
+    int symbolColumn = findColumn(fields, "Symbol");
+    int massColumn = findColumn(fields, "AtomicMass");
+    int electronegativityColumn = findColumn(fields, "Electronegativity");
+    if (numberColumn < 0 || symbolColumn < 0 || massColumn < 0 || electronegativityColumn < 0) return false;
+    int last = std::max(std::max(numberColumn, symbolColumn), std::max(massColumn, electronegativityColumn));
+
+    std::vector<std::string> rowSymbols(1, "*");
+    std::vector<double> rowMass(1, 0.0), rowElectronegativity(1, 0.0);
+    while (std::getline(input, line)) {
+        splitCsvLine(line, fields);
+        if ((int) fields.size() <= last) continue;
+        int number = std::atoi(fields[numberColumn].c_str());
+        const std::string& symbol = fields[symbolColumn];
+        if (number <= 0 || symbol.empty() || !isupper((unsigned char) symbol[0]) || symbol.size() > 2) continue;
+        if (number >= (int) rowSymbols.size()) {
+            rowSymbols.resize(number + 1);
+            rowMass.resize(number + 1, 0.0);
+            rowElectronegativity.resize(number + 1, 0.0);
+        }
+        rowSymbols[number] = symbol;
+        rowMass[number] = std::atof(fields[massColumn].c_str());
+        rowElectronegativity[number] = std::atof(fields[electronegativityColumn].c_str());
+    }
+    if (rowSymbols.size() <= 6 || rowElectronegativity[6] <= 0) return false; // carbon is the reference
+
+    symbols.clear();
+    std::memset(bySymbol, 0, sizeof(bySymbol));
+    averageMass = rowMass;
+    exactMass = rowMass;
+    electronegativity = rowElectronegativity;
+    electronegativity[0] = rowElectronegativity[6];
+    for (size_t i = 0; i < rowSymbols.size(); ++i) {
+        const std::string& symbol = rowSymbols[i];
+        symbols.add(i == 0 || symbol.empty() ? "*" : symbol);
+        if (electronegativity[i] <= 0) electronegativity[i] = electronegativity[6]; // noble gases
+        if (i == 0 || symbol.empty()) continue;
+        int second = symbol.size() == 2 && islower((unsigned char) symbol[1]) ? symbol[1] - 'a' + 1 : 0;
+        bySymbol[symbol[0] - 'A'][second] = (int16_t) i;
+    }
+    for (const auto& entry : MONOISOTOPIC) {
+        if (entry.number < (int) exactMass.size()) exactMass[entry.number] = entry.mass;
+    }
+    alphabetical.clear();
+    for (size_t i = 1; i < rowSymbols.size(); ++i) {
+        if (!rowSymbols[i].empty()) alphabetical.push_back(i);
+    }
+    std::sort(alphabetical.begin(), alphabetical.end(), [&](int a, int b) {
+        return rowSymbols[a] < rowSymbols[b];
+    });
+    return true;
+}
+
+int ElementTable::getAtomicNumber(const std::string& symbol) const {
+    if (symbol.empty() || symbol.size() > 2 || !isalpha((unsigned char) symbol[0])) return 0;
+    int first = toupper(symbol[0]) - 'A';
+    int second = 0;
+    if (symbol.size() == 2) {
+        if (!isalpha((unsigned char) symbol[1])) return 0;
+        second = tolower(symbol[1]) - 'a' + 1;
+    }
+    return bySymbol[first][second];
+}
+
+std::string ElementTable::getSymbol(int number) const {
+    return number > 0 && number < symbols.size() ? symbols[number] : "*";
+}
+
+DescriptorEngine::DescriptorEngine(const ElementTable& table) : elements(table) {}
+
+void DescriptorEngine::compute(const Molecule& mol, MolDescriptors& descriptors) {
+    rings.perceive(mol);
+    compute(mol, rings, descriptors);
+}
+
+void DescriptorEngine::compute(const Molecule& mol, const RingPerception& rings, MolDescriptors& descriptors) {
+    static const GatherSumFunction gatherSum = selectGatherSum();
+    static const GatherWeightFunction gatherWeight = selectGatherWeight();
+    pack(mol);
+    ArrayView<Atom*> atoms = mol.getAtoms();
+    size_t numAtoms = atomElement.size(), numBonds = bondOrder.size();
+
+    // counts and charges
+    descriptors.heavyAtoms = 0;
+    descriptors.hydrogens = 0;
+    descriptors.positiveCharge = 0;
+    descriptors.negativeCharge = 0;
+    for (size_t i = 0; i < numAtoms; ++i) {
+        if (atomElement[i] == 1) {
+            descriptors.hydrogens++;
+        } else {
+            descriptors.heavyAtoms++;
+        }
+        descriptors.hydrogens += atomHydrogens[i];
+        int charge = atoms[i]->getCharge();
+        (charge > 0 ? descriptors.positiveCharge : descriptors.negativeCharge) += charge;
+    }
+    descriptors.charge = descriptors.positiveCharge + descriptors.negativeCharge;
+
+    // masses: a gather over the atoms, the attached hydrogens, then the few isotopes written
+    int attached = descriptors.hydrogens - (int) (numAtoms - descriptors.heavyAtoms); // not atoms themselves
+    descriptors.averageMass = gatherSum(elements.averageMass.data(), atomElement.data(), numAtoms) +
+                              attached * elements.averageMass[1];
+    descriptors.exactMass = gatherSum(elements.exactMass.data(), atomElement.data(), numAtoms) +
+                            attached * elements.exactMass[1];
+    for (size_t i = 0; i < numAtoms; ++i) {
+        int isotope = atoms[i]->getIsotope();
+        if (isotope == 0 || atomElement[i] == 0) continue;
+        double mass = isotopeMass(atomElement[i], isotope);
+        descriptors.averageMass += mass - elements.averageMass[atomElement[i]];
+        descriptors.exactMass += mass - elements.exactMass[atomElement[i]];
+    }
+
+    // formula in Hill order, each isotope written after its element
+    elementCount.assign(elements.symbols.size(), 0);
+    isotopes.clear();
+    for (size_t i = 0; i < numAtoms; ++i) {
+        int isotope = atoms[i]->getIsotope();
+        if (isotope != 0 && atomElement[i] != 0) {
+            isotopes.push_back(std::make_pair(atomElement[i], isotope));
+        } else {
+            elementCount[atomElement[i]]++;
+        }
+    }
+    elementCount[1] += attached;
+    std::sort(isotopes.begin(), isotopes.end());
+    descriptors.formula.clear();
+    auto carbonIsotope = std::lower_bound(isotopes.begin(), isotopes.end(), std::make_pair(6, 0));
+    bool carbon = (elementCount.size() > 6 && elementCount[6] > 0) ||
+                  (carbonIsotope != isotopes.end() && carbonIsotope->first == 6);
+    if (carbon) {
+        appendElement(descriptors.formula, "C", 6, elementCount[6], isotopes);
+        appendElement(descriptors.formula, "H", 1, elementCount[1], isotopes);
+    }
+    for (int number : elements.alphabetical) {
+        if (carbon && (number == 1 || number == 6)) continue;
+        appendElement(descriptors.formula, elements.symbols[number], number, elementCount[number], isotopes);
+    }
+    appendCount(descriptors.formula, "*", elementCount[0]);
+
+    // rings
+    descriptors.rings = rings.getNumRings();
+    descriptors.ringSystems = rings.getNumRingSystems();
+    descriptors.aromaticRings = 0;
+    ArrayView<Bond*> bonds = mol.getBonds();
+    for (int ring = 0; ring < descriptors.rings; ++ring) { // a ring's atoms are the ends of its bonds
+        const BitVector& ringBonds = rings.getRingBondSet(ring);
+        bool aromatic = true;
+        for (size_t b = ringBonds.findFirst(); aromatic && b < ringBonds.size(); b = ringBonds.findNext(b)) {
+            aromatic = bonds[b]->getFirstAtom()->isAromatic() && bonds[b]->getSecondAtom()->isAromatic();
+        }
+        descriptors.aromaticRings += aromatic;
+    }
+
+    // electronegativity-weighted Laplacian: gathered bond weights, summed onto their atoms
+    weights.resize(numBonds);
+    gatherWeight(elements.electronegativity.data(), firstElement.data(), secondElement.data(),
+                 bondOrder.data(), 1.0 / elements.electronegativity[6], weights.data(), numBonds);
+    descriptors.bondWeights.clear();
+    descriptors.atomWeights.clear();
+    for (size_t i = 0; i < numAtoms; ++i) descriptors.atomWeights.add(0.0);
+    for (size_t i = 0; i < numBonds; ++i) {
+        descriptors.bondWeights.add(weights[i]);
+        descriptors.atomWeights[bondAtoms[2 * i]] += weights[i];
+        descriptors.atomWeights[bondAtoms[2 * i + 1]] += weights[i];
+    }
+}
+
+/*
+ * Fills the flat arrays: atomic numbers, bond ends and orders, and the
+ * hydrogens on each atom.
+ */
+void DescriptorEngine::pack(const Molecule& mol) {
+    ArrayView<Atom*> atoms = mol.getAtoms();
+    ArrayView<Bond*> bonds = mol.getBonds();
+    atomElement.resize(atoms.size());
+    bondAtoms.resize(2 * bonds.size());
+    firstElement.resize(bonds.size());
+    secondElement.resize(bonds.size());
+    bondOrder.resize(bonds.size());
+    for (int i = 0; i < atoms.size(); ++i) {
+        atomElement[i] = elements.getAtomicNumber(atoms[i]->getAbbreviation());
+    }
+    for (int i = 0; i < bonds.size(); ++i) {
+        int first = bonds[i]->getFirstAtom()->getIndex();
+        int second = bonds[i]->getSecondAtom()->getIndex();
+        int order = bonds[i]->getOrder();
+        bondAtoms[2 * i] = first;
+        bondAtoms[2 * i + 1] = second;
+        firstElement[i] = atomElement[first];
+        secondElement[i] = atomElement[second];
+        bondOrder[i] = order;
+    }
+    countHydrogens(mol, atomHydrogens);
+}
+
+void countHydrogens(const Molecule& mol, std::vector<int32_t>& hydrogens) {
+    ArrayView<Atom*> atoms = mol.getAtoms();
+    hydrogens.assign(atoms.size(), 0);
+    for (Bond * bond : mol.getBonds()) { // the valence used so far, for now
+        hydrogens[bond->getFirstAtom()->getIndex()] += bond->getOrder();
+        hydrogens[bond->getSecondAtom()->getIndex()] += bond->getOrder();
+    }
+    for (int i = 0; i < atoms.size(); ++i) {
+        Atom * atom = atoms[i];
+        hydrogens[i] = atom->isBracket() ? atom->getHCount() :
+            implicitHydrogens(organicNumber(atom->getAbbreviation()), atom->isAromatic(), hydrogens[i]);
+    }
+}
+
+/*
+ * Splits a line of CSV into fields, allowing double-quoted fields with commas.
+ */
+static void splitCsvLine(const std::string& line, std::vector<std::string>& fields) {
+    fields.clear();
+    fields.emplace_back();
+    bool quoted = false;
+    for (char c : line) {
+        if (c == '"') {
+            quoted = !quoted;
+        } else if (c == ',' && !quoted) {
+            fields.emplace_back();
+        } else if (c != '\r' && c != '\n') {
+            fields.back() += c;
+        }
+    }
+}
+
+static int findColumn(const std::vector<std::string>& header, const std::string& name) {
+    for (size_t i = 0; i < header.size(); ++i) {
+        if (header[i] == name) return i;
+    }
+    return -1;
+}
+
+static double isotopeMass(int number, int isotope) {
+    for (const auto& entry : ISOTOPES) {
+        if (entry.number == number && entry.isotope == isotope) return entry.mass;
+    }
+    return isotope;
+}
+
+/*
+ * The atomic number of an organic-subset symbol, aromatic or not, or 0 for
+ * any other.
+ */
+static int organicNumber(const std::string& symbol) {
+    if (symbol == "Cl") return 17;
+    if (symbol == "Br") return 35;
+    if (symbol.size() != 1) return 0;
+    switch (symbol[0]) {
+    case 'B': case 'b': return 5;
+    case 'C': case 'c': return 6;
+    case 'N': case 'n': return 7;
+    case 'O': case 'o': return 8;
+    case 'F': return 9;
+    case 'P': case 'p': return 15;
+    case 'S': case 's': return 16;
+    case 'I': return 53;
+    default: return 0;
+    }
+}
+
+/*
+ * The hydrogens implied on an organic-subset atom: enough to bring the
+ * valence used by its bonds up to the next normal valence of its element
+ * (OpenSMILES). Aromatic atoms use one valence more than their single
+ * aromatic bonds show and only their lowest normal valence, which gives
+ * the usual one hydrogen on c and none on n, o or s.
+ */
+static int implicitHydrogens(int number, bool aromatic, int valence) {
+    static const int BORON[] = {3}, CARBON[] = {4}, NITROGEN[] = {3, 5}, OXYGEN[] = {2};
+    static const int PHOSPHORUS[] = {3, 5}, SULFUR[] = {2, 4, 6}, HALOGEN[] = {1};
+    const int* normal;
+    int count;
+    switch (number) {
+    case 5: normal = BORON; count = 1; break;
+    case 6: normal = CARBON; count = 1; break;
+    case 7: normal = NITROGEN; count = 2; break;
+    case 8: normal = OXYGEN; count = 1; break;
+    case 15: normal = PHOSPHORUS; count = 2; break;
+    case 16: normal = SULFUR; count = 3; break;
+    case 9: case 17: case 35: case 53: normal = HALOGEN; count = 1; break;
+    default: return 0;
+    }
+    if (aromatic) {
+        valence++;
+        count = 1;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (normal[i] >= valence) return normal[i] - valence;
+    }
+    return 0;
+}
+
+static void appendCount(std::string& formula, const std::string& symbol, int count) {
+    if (count <= 0) return;
+    formula += symbol;
+    if (count > 1) formula += std::to_string(count);
+}
+
+/*
+ * Appends the count of an element, then of each of its isotopes in the sorted
+ * list, lightest first: D and T for hydrogen, [13C] and the like otherwise.
+ */
+static void appendElement(std::string& formula, const std::string& symbol, int number, int count,
+                          const std::vector<std::pair<int, int>>& isotopes) {
+    appendCount(formula, symbol, count);
+    auto next = std::lower_bound(isotopes.begin(), isotopes.end(), std::make_pair(number, 0));
+    while (next != isotopes.end() && next->first == number) {
+        int isotope = next->second, same = 0;
+        for (; next != isotopes.end() && *next == std::make_pair(number, isotope); ++next) same++;
+        if (number == 1 && (isotope == 2 || isotope == 3)) {
+            appendCount(formula, isotope == 2 ? "D" : "T", same);
+        } else {
+            appendCount(formula, "[" + std::to_string(isotope) + symbol + "]", same);
+        }
+    }
+}
+
+/*
+ * Both versions of each kernel keep four running sums, lane i taking
+ * elements i, i + 4, ..., and add them as (0 + 1) + (2 + 3), so the
+ * scalar and vector results are the same to the last bit.
+ */
+static double gatherSumScalar(const double* table, const int32_t* index, size_t n) {
+    double lane[4] = {0, 0, 0, 0};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (int k = 0; k < 4; ++k) lane[k] += table[index[i + k]];
+    }
+    double sum = (lane[0] + lane[1]) + (lane[2] + lane[3]);
+    for (; i < n; ++i) sum += table[index[i]];
+    return sum;
+}
+
+static void gatherWeightScalar(const double* table, const int32_t* first, const int32_t* second,
+                               const int32_t* order, double scale, double* weight, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        weight[i] = double(order[i]) * std::sqrt(table[first[i]] * table[second[i]]) * scale;
+    }
+}
+
+#ifdef RETROCHEM_X86_DISPATCH
+
+// table[index[0..3]]; the masked form, as the plain one starts from an undefined register
+__attribute__((target("avx2")))
+static __m256d gather4(const double* table, const int32_t* index) {
+    __m128i indices = _mm_loadu_si128(reinterpret_cast<const __m128i*>(index));
+    __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), table, indices, all, 8);
+}
+
+__attribute__((target("avx2")))
+static double gatherSumAVX2(const double* table, const int32_t* index, size_t n) {
+    __m256d lanes = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        lanes = _mm256_add_pd(lanes, gather4(table, index + i));
+    }
+    double lane[4];
+    _mm256_storeu_pd(lane, lanes);
+    double sum = (lane[0] + lane[1]) + (lane[2] + lane[3]);
+    for (; i < n; ++i) sum += table[index[i]];
+    return sum;
+}
+
+__attribute__((target("avx2")))
+static void gatherWeightAVX2(const double* table, const int32_t* first, const int32_t* second,
+                             const int32_t* order, double scale, double* weight, size_t n) {
+    __m256d scales = _mm256_set1_pd(scale);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d one = gather4(table, first + i);
+        __m256d two = gather4(table, second + i);
+        __m256d orders = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(order + i)));
+        __m256d mean = _mm256_sqrt_pd(_mm256_mul_pd(one, two));
+        _mm256_storeu_pd(weight + i, _mm256_mul_pd(_mm256_mul_pd(orders, mean), scales));
+    }
+    gatherWeightScalar(table, first + i, second + i, order + i, scale, weight + i, n - i);
+}
+
+#endif
+
+static GatherSumFunction selectGatherSum() {
+#ifdef RETROCHEM_X86_DISPATCH
+    if (cpuSupportsAVX2()) return gatherSumAVX2;
+#endif
+    return gatherSumScalar;
+}
+
+static GatherWeightFunction selectGatherWeight() {
+#ifdef RETROCHEM_X86_DISPATCH
+    if (cpuSupportsAVX2()) return gatherWeightAVX2;
+#endif
+    return gatherWeightScalar;
+}
@@ -0,0 +1,163 @@
+/**
+ * File: descriptors.h
+ * -------------------
+ * This file contains the interface for RetroCHEM's molecular descriptors.
+ * An ElementTable holds the per-element data of res/periodictable.csv
+ * as a structure of arrays indexed by atomic number, and a
+ * DescriptorEngine uses it to compute, for one molecule after another,
+ * its molecular formula, masses, atom counts, formal charges, ring
+ * counts and the bond weights of an electronegativity-weighted Laplacian.
+ * A bond weighs its order times the geometric mean of the Pauling
+ * electronegativities of its two atoms, divided by carbon's, so bonds
+ * between carbons keep the weights MolGraph gives them.
+ *
+ * The engine packs each molecule's atoms and bonds into flat arrays of
+ * atomic numbers, and the sums over them are gathers from the element
+ * tables, done four at a time with AVX2 when the processor has it. The
+ * scalar fallback adds in the same order, so both give identical results.
+ */
+
+#ifndef _descriptors_h
+#define _descriptors_h
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "vector.h"
+#include "molecule.h"
+#include "rings.h"
+
+/**
+ * Struct: MolDescriptors
+ * ----------------------
+ * The descriptors of one molecule. Hydrogens include the implicit ones of
+ * organic-subset atoms; heavy atoms are all atoms other than hydrogen.
+ */
+struct MolDescriptors {
+    std::string formula;        // Hill order: C, H, then alphabetical; isotopes as D, T or [13C]
+    double exactMass = 0;       // monoisotopic, or of the isotopes written
+    double averageMass = 0;     // standard atomic weights
+    int heavyAtoms = 0;
+    int hydrogens = 0;
+    int charge = 0;             // net formal charge
+    int positiveCharge = 0;     // sum of the positive formal charges
+    int negativeCharge = 0;     // sum of the negative formal charges
+    int rings = 0;              // size of the SSSR
+    int ringSystems = 0;
+    int aromaticRings = 0;      // SSSR rings of aromatic atoms only
+    Vector<double> bondWeights; // Laplacian weight of each bond, by bond index
+    Vector<double> atomWeights; // their sum over each atom's bonds (the diagonal)
+};
+
+/**
+ * Function: countHydrogens
+ * Parameters: mol, hydrogens
+ * Usage: countHydrogens(mol, hydrogens);
+ * --------------------------------------
+ * Fills hydrogens with the number of hydrogens on each atom of mol, by atom
+ * index: the count written in a bracket atom, or for an organic-subset atom
+ * the count implied by the bond orders around it (OpenSMILES).
+ */
+void countHydrogens(const Molecule& mol, std::vector<int32_t>& hydrogens);
+
+class ElementTable {
+public:
+    /**
+     * Constructor: ElementTable
+     * Usage: ElementTable elements;
+     * -----------------------------
+     * Initializes an empty table; every symbol is unknown until load is called.
+     */
+    ElementTable();
+
+    /**
+     * Function: load
+     * Parameters: path
+     * Usage: if (!elements.load("res/periodictable.csv")) {...}
+     * ---------------------------------------------------------
+     * Reads the periodic table from a CSV file with AtomicNumber, Symbol,
+     * AtomicMass and Electronegativity columns. Returns false if the file
+     * cannot be read or lacks one of those columns.
+     */
+    bool load(const std::string& path);
+
+    /**
+     * Function: getAtomicNumber
+     * Parameters: symbol
+     * Usage: int z = elements.getAtomicNumber("Cl");
+     * ----------------------------------------------
+     * Returns the atomic number of an element symbol, which may be written
+     * in lowercase as an aromatic SMILES atom, or 0 if it is unknown.
+     */
+    int getAtomicNumber(const std::string& symbol) const;
+
+    /**
+     * Function: getSymbol
+     * Parameters: number
+     * Usage: std::string symbol = elements.getSymbol(6);
+     * --------------------------------------------------
+     * Returns the symbol of the element with the given atomic number.
+     */
+    std::string getSymbol(int number) const;
+
+private:
+    // one entry per atomic number; entry 0 stands for unknown atoms such as '*'
+    std::vector<double> averageMass;
+    std::vector<double> exactMass;         // most abundant isotope (average mass if not listed)
+    std::vector<double> electronegativity; // Pauling; carbon's where the table has none
+    Vector<std::string> symbols;
+    std::vector<int> alphabetical;         // atomic numbers ordered by symbol, for formulas
+    int16_t bySymbol[26][27];              // [capital letter][second letter, 0 if none]
+
+    friend class DescriptorEngine;
+};
+
+class DescriptorEngine {
+public:
+    /**
+     * Constructor: DescriptorEngine
+     * Parameters: elements
+     * Usage: DescriptorEngine engine(elements);
+     * -----------------------------------------
+     * Initializes an engine that reads element data from the table, which
+     * must outlive it. Engines keep their scratch space between molecules,
+     * so each thread should have its own.
+     */
+    DescriptorEngine(const ElementTable& elements);
+
+    /**
+     * Function: compute
+     * Parameters: mol, descriptors
+     * Usage: engine.compute(mol, descriptors);
+     * ----------------------------------------
+     * Fills descriptors with those of the molecule, replacing its contents.
+     */
+    void compute(const Molecule& mol, MolDescriptors& descriptors);
+
+    /**
+     * Function: compute
+     * Parameters: mol, rings, descriptors
+     * Usage: engine.compute(mol, molgraph.getRings(), descriptors);
+     * -------------------------------------------------------------
+     * As above, using rings already perceived in the molecule instead of
+     * perceiving them again.
+     */
+    void compute(const Molecule& mol, const RingPerception& rings, MolDescriptors& descriptors);
+
+private:
+    const ElementTable& elements;
+
+    // the molecule packed into flat arrays
+    std::vector<int32_t> atomElement;   // atomic number of each atom
+    std::vector<int32_t> atomHydrogens; // explicit and implicit hydrogens of each atom
+    std::vector<int32_t> bondAtoms;     // two atom indices per bond
+    std::vector<int32_t> firstElement, secondElement, bondOrder;
+    std::vector<double> weights;
+    std::vector<int> elementCount;      // by atomic number, for the formula
+    std::vector<std::pair<int, int>> isotopes; // element and mass number of each isotope written
+    RingPerception rings;
+
+    void pack(const Molecule& mol);
+};
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ * File: fiedler.cpp
+ * -----------------
+ * This file contains the implementation for the fiedler interface.
+ * Documentation for each function can be found in the fiedler.h file.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "fiedler.h"
+
+void findFiedlerEigenspace(const double* values, int n, int& first, int& last) {
+    double tolerance = 1e-8 * std::max(1.0, std::abs(values[n - 1]));
+    first = last = 1;
+    while (first > 0 && std::abs(values[first - 1] - values[1]) <= tolerance) first--;
+    while (last + 1 < n && std::abs(values[last + 1] - values[1]) <= tolerance) last++;
+}
+
+/*
+ * The projection of a vertex's unit vector is the same whichever basis of
+ * the eigenspace it is computed from. Graph colours do not depend on the
+ * atom order, so when MolGraph passes them, isomorphic molecules get the
+ * same vector, up to their symmetry.
+ */
+void canonicalFiedler(const double* basis, int n, int columns, bool constant,
+                      const std::vector<uint64_t>& colors, std::vector<int>& order,
+                      std::vector<double>& fiedler) {
+    order.resize(n);
+    for (int i = 0; i < n; ++i) order[i] = i;
+    if (!colors.empty()) {
+        std::sort(order.begin(), order.end(), [&](int x, int y) {
+            return colors[x] < colors[y] || (colors[x] == colors[y] && x < y);
+        });
+    }
+    fiedler.assign(n, 0.0);
+    for (int vertex : order) {
+        std::fill(fiedler.begin(), fiedler.end(), 0.0);
+        for (int k = 0; k < columns; ++k) {
+            const double* vector = basis + (size_t) k * n;
+            double weight = vector[vertex];
+            for (int i = 0; i < n; ++i) fiedler[i] += weight * vector[i];
+        }
+        if (constant) { // take out the constant vector
+            double mean = 0;
+            for (double value : fiedler) mean += value / n;
+            for (double& value : fiedler) value -= mean;
+        }
+        double norm = 0;
+        for (double value : fiedler) norm += value * value;
+        norm = std::sqrt(norm);
+        if (norm > 1e-8) {
+            for (double& value : fiedler) value /= norm;
+            break;
+        }
+    }
+}
@@ -0,0 +1,48 @@
+/**
+ * File: fiedler.h
+ * ---------------
+ * This file contains the functions that choose a Fiedler vector from a
+ * Laplacian's eigendecomposition. The eigenvector eig_sym returns for
+ * the second smallest eigenvalue has an arbitrary sign, and when that
+ * eigenvalue is repeated, an arbitrary direction within its eigenspace;
+ * both depend on the LAPACK build and its thread count. These functions
+ * pick one vector from the eigenspace by a rule that does not, so the
+ * spectral split and the multilevel partitioner give the same clusters
+ * everywhere.
+ */
+
+#ifndef _fiedler_h
+#define _fiedler_h
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Function: findFiedlerEigenspace
+ * Parameters: values, n, first, last
+ * Usage: findFiedlerEigenspace(eigenvalues.memptr(), n, first, last);
+ * -------------------------------------------------------------------
+ * Finds the eigenvalues equal to the second smallest of the n given in
+ * ascending order, as the ones from first to last.
+ */
+void findFiedlerEigenspace(const double* values, int n, int& first, int& last);
+
+/**
+ * Function: canonicalFiedler
+ * Parameters: basis, n, columns, constant, colors, order, fiedler
+ * Usage: canonicalFiedler(vectors.colptr(first), n, last - first + 1, first == 0,
+ *                         colors, order, fiedler);
+ * ------------------------------------------------------------------------------
+ * Sets fiedler to the projection of one vertex's unit vector onto the
+ * eigenspace spanned by the n-by-columns basis (column-major, without the
+ * constant vector when constant is set because the eigenvalue is zero),
+ * normalized. Vertices are tried by colour, then index, until the
+ * projection does not vanish; colors may be empty to go by index alone.
+ * The result does not depend on the basis chosen and is positive on that
+ * vertex. order is scratch space.
+ */
+void canonicalFiedler(const double* basis, int n, int columns, bool constant,
+                      const std::vector<uint64_t>& colors, std::vector<int>& order,
+                      std::vector<double>& fiedler);
+
+#endif
@@ -0,0 +1,318 @@
+/**
+ * File: graphexport.cpp
+ * ---------------------
+ * This file contains the implementation for the graphexport interface.
+ * Documentation for each function can be found in the graphexport.h file.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <vector>
+#include "descriptors.h"
+#include "graphexport.h"
+
+// helper function declarations
+static void appendMatrixMarket(const Molecule& mol, long id, std::string& out);
+static void appendEdgeList(const Molecule& mol, long id, std::string& out);
+static void appendCsr(const Molecule& mol, long id, std::string& out);
+template <typename T>
+static void appendBinary(std::string& out, T value);
+template <typename T>
+static T readBinary(const char*& bytes);
+static std::string sizeLine(long rows, long entries);
+
+void appendGraph(const Molecule& mol, long id, ExportFormat format, std::string& out) {
+    switch (format) {
+    case MatrixMarketExport:
+        appendMatrixMarket(mol, id, out);
+        break;
+    case EdgeListExport:
+        appendEdgeList(mol, id, out);
+        break;
+    case CsrExport:
+        appendCsr(mol, id, out);
+        break;
+    }
+}
+
+// the Matrix Market header, followed by a size line of fixed width that is filled in on close
+static const std::string MATRIX_MARKET_HEADER = "%%MatrixMarket matrix coordinate real symmetric\n"
+                                                "% molecules are listed in the .index file beside this one\n";
+static const size_t SIZE_LINE_WIDTH = 64;
+
+GraphWriter::GraphWriter(const std::string& file, ExportFormat type, long size) :
+    path(file), format(type), shardSize(size), inShard(0), numShards(0), failed(false), rows(0), entries(0) {}
+
+bool GraphWriter::open() {
+    openShard();
+    return !hasFailed();
+}
+
+void GraphWriter::write(const std::string& graph) {
+    if (numShards == 0 || (format == CsrExport && inShard == shardSize)) openShard();
+    if (format == MatrixMarketExport) {
+        writeMatrixMarket(graph);
+    } else {
+        out.write(graph.data(), graph.size());
+    }
+    inShard++;
+}
+
+bool GraphWriter::hasFailed() const {
+    return failed || (out.is_open() && !out) || (index.is_open() && !index);
+}
+
+bool GraphWriter::close() {
+    if (numShards == 0 && format != CsrExport) openShard(); // an empty file, but a file
+    if (format == MatrixMarketExport && out.is_open()) { // the size is known at last
+        std::string size = sizeLine(rows, entries);
+        out.seekp(MATRIX_MARKET_HEADER.size());
+        out.write(size.data(), size.size());
+    }
+    if (index.is_open()) {
+        index.flush();
+        failed = failed || !index;
+        index.close();
+    }
+    if (out.is_open()) {
+        out.flush();
+        failed = failed || !out;
+        out.close();
+    }
+    return !failed;
+}
+
+GraphWriter::Position GraphWriter::getPosition() {
+    Position at;
+    at.shards = numShards;
+    at.molecules = inShard;
+    if (index.is_open()) {
+        index.flush();
+        failed = failed || !index;
+    }
+    if (out.is_open()) {
+        out.flush();
+        failed = failed || !out;
+        at.bytes = out.tellp();
+    }
+    return at;
+}
+
+void GraphWriter::listFiles(std::vector<std::string>& files) {
+    files.insert(files.end(), written.begin(), written.end());
+    written.clear();
+    if (out.is_open()) written.push_back(file);
+    if (index.is_open()) written.push_back(path + ".index");
+}
+
+bool GraphWriter::resume(const Position& at) {
+    if (out.is_open()) out.close();
+    if (index.is_open()) index.close();
+    numShards = at.shards;
+    inShard = at.molecules;
+    if (numShards == 0) return open(); // nothing written yet
+    file = path;
+    if (format == CsrExport) {
+        char suffix[16];
+        std::snprintf(suffix, sizeof(suffix), ".%05d", numShards - 1);
+        file += suffix;
+    }
+    std::error_code problem;
+    std::uintmax_t size = std::filesystem::file_size(file, problem);
+    if (problem || size < (std::uintmax_t) at.bytes) return false;
+    std::filesystem::resize_file(file, at.bytes, problem);
+    if (problem) return false;
+
+    // the index has a line for each molecule written, from which the matrix size follows
+    if (format == MatrixMarketExport) {
+        std::ifstream saved(path + ".index");
+        std::string line;
+        long kept = 0;
+        rows = entries = 0;
+        for (long i = 0; i < at.molecules; ++i) {
+            long id, first, atoms, bonds;
+            if (!std::getline(saved, line)) return false;
+            std::istringstream fields(line);
+            if (!(fields >> id >> first >> atoms >> bonds)) return false;
+            rows += atoms;
+            entries += bonds;
+            kept += line.size() + 1;
+        }
+        saved.close();
+        std::filesystem::resize_file(path + ".index", kept, problem);
+        if (problem) return false;
+        index.open(path + ".index", std::ios::binary | std::ios::in | std::ios::out);
+        index.seekp(0, std::ios::end);
+        written.push_back(path + ".index");
+    }
+    written.push_back(file);
+    out.open(file, std::ios::binary | std::ios::in | std::ios::out);
+    out.seekp(0, std::ios::end);
+    failed = hasFailed();
+    return !failed;
+}
+
+void GraphWriter::openShard() {
+    if (format != CsrExport) { // the text formats go to a single file
+        file = path;
+        written.push_back(file);
+        out.open(file, std::ios::binary);
+        failed = failed || !out;
+        numShards = 1;
+        if (format == MatrixMarketExport) {
+            out << MATRIX_MARKET_HEADER << sizeLine(0, 0);
+            written.push_back(path + ".index");
+            index.open(path + ".index", std::ios::binary);
+            failed = failed || !index;
+            rows = entries = 0;
+        }
+        return;
+    }
+    close();
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), ".%05d", numShards++);
+    file = path + suffix;
+    written.push_back(file);
+    out.open(file, std::ios::binary);
+    failed = failed || !out;
+    std::string header = "RCSR";
+    appendBinary<uint32_t>(header, 1);
+    appendBinary<uint32_t>(header, 0x01020304);
+    out.write(header.data(), header.size());
+    inShard = 0;
+}
+
+/*
+ * Turns a record made by appendMatrixMarket into the molecule's block of the
+ * matrix, below and to the right of the blocks written so far, and lists the
+ * molecule in the index.
+ */
+void GraphWriter::writeMatrixMarket(const std::string& graph) {
+    const char* bytes = graph.data();
+    int64_t id = readBinary<int64_t>(bytes);
+    int32_t atoms = readBinary<int32_t>(bytes);
+    int32_t bonds = readBinary<int32_t>(bytes);
+    text.clear();
+    for (int32_t i = 0; i < bonds; ++i) {
+        int32_t row = readBinary<int32_t>(bytes);
+        int32_t col = readBinary<int32_t>(bytes);
+        int32_t order = readBinary<int32_t>(bytes);
+        text += std::to_string(rows + row + 1) + ' ' + std::to_string(rows + col + 1) + ' ' +
+                std::to_string(order) + '\n';
+    }
+    out.write(text.data(), text.size());
+    index << id << ' ' << rows + 1 << ' ' << atoms << ' ' << bonds << '\n';
+    rows += atoms;
+    entries += bonds;
+}
+
+/*
+ * Matrix Market row numbers depend on the molecules written before, so this
+ * only records the bonds, as int64 id, int32 atoms, int32 bonds and then
+ * int32 row, column and order for each bond (0-based, row > column), for
+ * GraphWriter to number.
+ */
+static void appendMatrixMarket(const Molecule& mol, long id, std::string& out) {
+    ArrayView<Bond*> bonds = mol.getBonds();
+    appendBinary<int64_t>(out, id);
+    appendBinary<int32_t>(out, mol.getAtoms().size());
+    appendBinary<int32_t>(out, bonds.size());
+    for (Bond * bond : bonds) {
+        int a = bond->getFirstAtom()->getIndex(), b = bond->getSecondAtom()->getIndex();
+        appendBinary<int32_t>(out, std::max(a, b));
+        appendBinary<int32_t>(out, std::min(a, b));
+        appendBinary<int32_t>(out, bond->getOrder());
+    }
+}
+
+static void appendEdgeList(const Molecule& mol, long id, std::string& out) {
+    ArrayView<Atom*> atoms = mol.getAtoms();
+    ArrayView<Bond*> bonds = mol.getBonds();
+    static thread_local std::vector<int32_t> hydrogens;
+    countHydrogens(mol, hydrogens);
+    out += "# molecule " + std::to_string(id) + " atoms " + std::to_string(atoms.size()) +
+           " bonds " + std::to_string(bonds.size()) + '\n';
+    for (Atom * atom : atoms) {
+        out += "a " + std::to_string(atom->getIndex()) + ' ' + atom->getAbbreviation() + ' ' +
+               std::to_string(atom->getCharge()) + ' ' + std::to_string(hydrogens[atom->getIndex()]) + ' ' +
+               std::to_string(atom->getIsotope()) + ' ' + (atom->isAromatic() ? '1' : '0') + '\n';
+    }
+    for (Bond * bond : bonds) {
+        out += "b " + std::to_string(bond->getFirstAtom()->getIndex()) + ' ' +
+               std::to_string(bond->getSecondAtom()->getIndex()) + ' ' +
+               std::to_string(bond->getOrder()) + '\n';
+    }
+}
+
+/*
+ * Builds the compressed rows with a counting sort over the bond list, then
+ * sorts each (short) row by column.
+ */
+static void appendCsr(const Molecule& mol, long id, std::string& out) {
+    ArrayView<Atom*> atoms = mol.getAtoms();
+    ArrayView<Bond*> bonds = mol.getBonds();
+    int natoms = atoms.size(), nnz = 2 * bonds.size();
+    static thread_local std::vector<int32_t> rowStart, fill;
+    static thread_local std::vector<std::pair<int32_t, uint8_t>> entries; // column, order
+    static thread_local std::vector<int32_t> hydrogens;
+    rowStart.assign(natoms + 1, 0);
+    for (Bond * bond : bonds) {
+        rowStart[bond->getFirstAtom()->getIndex() + 1]++;
+        rowStart[bond->getSecondAtom()->getIndex() + 1]++;
+    }
+    for (int i = 0; i < natoms; ++i) rowStart[i + 1] += rowStart[i];
+    fill.assign(rowStart.begin(), rowStart.end() - 1);
+    entries.resize(nnz);
+    for (Bond * bond : bonds) {
+        int a = bond->getFirstAtom()->getIndex(), b = bond->getSecondAtom()->getIndex();
+        uint8_t order = bond->getOrder();
+        entries[fill[a]++] = std::make_pair(b, order);
+        entries[fill[b]++] = std::make_pair(a, order);
+    }
+    for (int i = 0; i < natoms; ++i) {
+        std::sort(entries.begin() + rowStart[i], entries.begin() + rowStart[i + 1]);
+    }
+
+    appendBinary<int64_t>(out, id);
+    appendBinary<int32_t>(out, natoms);
+    appendBinary<int32_t>(out, nnz);
+    for (int32_t start : rowStart) appendBinary<int32_t>(out, start);
+    for (const std::pair<int32_t, uint8_t>& entry : entries) appendBinary<int32_t>(out, entry.first);
+    for (const std::pair<int32_t, uint8_t>& entry : entries) appendBinary<uint8_t>(out, entry.second);
+    countHydrogens(mol, hydrogens);
+    for (Atom * atom : atoms) {
+        std::string element = atom->getAbbreviation();
+        element.resize(2, '\0');
+        out += element;
+        appendBinary<int8_t>(out, atom->getCharge());
+        appendBinary<uint8_t>(out, hydrogens[atom->getIndex()]);
+        appendBinary<uint16_t>(out, atom->getIsotope());
+        appendBinary<uint8_t>(out, atom->isAromatic());
+        appendBinary<uint8_t>(out, 0);
+    }
+}
+
+template <typename T>
+static void appendBinary(std::string& out, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+template <typename T>
+static T readBinary(const char*& bytes) {
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    bytes += sizeof(T);
+    return value;
+}
+
+static std::string sizeLine(long rows, long entries) {
+    std::string line = std::to_string(rows) + ' ' + std::to_string(rows) + ' ' + std::to_string(entries);
+    line.resize(SIZE_LINE_WIDTH - 1, ' ');
+    return line + '\n';
+}
@@ -0,0 +1,194 @@
+/**
+ * File: graphexport.h
+ * -------------------
+ * This file contains the interface for exporting molecular graphs in
+ * sparse formats for downstream machine-learning pipelines. Graphs are
+ * written straight from a Molecule's bond list, one molecule after
+ * another, without building any matrix. The formats are:
+ *
+ * Matrix Market: the whole export is a single coordinate matrix that
+ * holds the molecules as blocks on its diagonal. Each block is the lower
+ * triangle of a molecule's symmetric bond-order-weighted adjacency
+ * matrix; rows and columns are 1-based:
+ *
+ *     %%MatrixMarket matrix coordinate real symmetric
+ *     % molecules are listed in the .index file beside this one
+ *     <rows> <rows> <entries>
+ *     <row> <col> <bond order>         (one line per bond, row > col)
+ *
+ * The size line is filled in when the writer is closed. <path>.index
+ * has one line per molecule,
+ *
+ *     <id> <first row> <atoms> <bonds>
+ *
+ * and the molecule takes rows and columns first row to first row +
+ * atoms - 1.
+ *
+ * Edge list: a header line, one line per atom with its features, and
+ * one line per bond, all 0-based:
+ *
+ *     # molecule <id> atoms <atoms> bonds <bonds>
+ *     a <atom> <element> <charge> <hydrogens> <isotope> <aromatic>
+ *     b <atom> <atom> <bond order>
+ *
+ * Binary CSR shards: a file header (the bytes "RCSR", a uint32 version,
+ * currently 1, and the uint32 0x01020304 to show the byte order), then
+ * one record per molecule:
+ *
+ *     int64 id, int32 atoms, int32 nnz
+ *     int32 rowStart[atoms + 1], int32 column[nnz], uint8 order[nnz]
+ *     atoms x 8 bytes of features: char element[2], int8 charge,
+ *         uint8 hydrogens, uint16 isotope, uint8 aromatic, uint8 zero
+ *
+ * where every bond appears in the rows of both its atoms (nnz = 2 x bonds)
+ * and columns are ascending within a row. All numbers are in the native
+ * byte order.
+ *
+ * In both, an atom's hydrogens include the implicit ones of organic-subset
+ * atoms, counted as for the descriptors (see countHydrogens).
+ */
+
+#ifndef _graphexport_h
+#define _graphexport_h
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "molecule.h"
+
+/**
+ * Enum: ExportFormat
+ * ------------------
+ * The sparse formats graphs can be exported in.
+ */
+enum ExportFormat {
+    MatrixMarketExport,
+    EdgeListExport,
+    CsrExport
+};
+
+/**
+ * Function: appendGraph
+ * Parameters: mol, id, format, out
+ * Usage: appendGraph(mol, line, CsrExport, bytes);
+ * ------------------------------------------------
+ * Appends the molecule's graph, tagged with id, to out in the given format.
+ * Only the bonds are visited; the cost is linear in the molecule's size.
+ * For Matrix Market, whose row numbers depend on the molecules before, out
+ * gets a compact record that GraphWriter turns into text.
+ */
+void appendGraph(const Molecule& mol, long id, ExportFormat format, std::string& out);
+
+class GraphWriter {
+public:
+    /**
+     * Struct: Position
+     * ----------------
+     * How far a writer has got: the number of files started (shards, for
+     * binary CSR), the molecules in the last one, and the bytes in it.
+     */
+    struct Position {
+        int shards = 0;
+        long molecules = 0;
+        long bytes = 0;
+    };
+
+    /**
+     * Constructor: GraphWriter
+     * Parameters: path, format, shardSize
+     * Usage: GraphWriter writer(path, CsrExport, 100000);
+     * ---------------------------------------------------
+     * Prepares to write graphs to path. Binary CSR output is split into
+     * shards of at most shardSize molecules, named path.00000, path.00001...;
+     * the text formats go to path itself.
+     */
+    GraphWriter(const std::string& path, ExportFormat format, long shardSize = 100000);
+
+    /**
+     * Function: open
+     * Usage: if (!writer.open()) {...}
+     * --------------------------------
+     * Creates the first file, so that a path that cannot be written is
+     * found before any work is done. Returns false if it cannot be created.
+     */
+    bool open();
+
+    /**
+     * Function: write
+     * Parameters: graph
+     * Usage: writer.write(bytes);
+     * ---------------------------
+     * Writes one molecule's graph, as made by appendGraph, starting a new
+     * shard first if the current one is full.
+     */
+    void write(const std::string& graph);
+
+    /**
+     * Function: hasFailed
+     * Usage: if (writer.hasFailed()) {...}
+     * ------------------------------------
+     * Returns true if a file could not be opened or written so far.
+     */
+    bool hasFailed() const;
+
+    /**
+     * Function: close
+     * Usage: if (!writer.close()) {...}
+     * ---------------------------------
+     * Flushes and closes the current file. Returns false if anything could
+     * not be written.
+     */
+    bool close();
+
+    /**
+     * Function: getPosition
+     * Usage: GraphWriter::Position at = writer.getPosition();
+     * -------------------------------------------------------
+     * Flushes the current file and returns how far the writer has got.
+     */
+    Position getPosition();
+
+    /**
+     * Function: listFiles
+     * Parameters: files
+     * Usage: writer.listFiles(files);
+     * -------------------------------
+     * Adds to files the paths of the files written since the last call,
+     * including the ones still open, so that they can be synced to disk
+     * before a checkpoint at the current position is trusted.
+     */
+    void listFiles(std::vector<std::string>& files);
+
+    /**
+     * Function: resume
+     * Parameters: at
+     * Usage: if (!writer.resume(at)) {...}
+     * ------------------------------------
+     * Picks up where a previous writer to the same path stopped at the given
+     * position, cutting off anything written to its file after that point.
+     * Returns false if the file is missing or shorter than the position.
+     * Used instead of open.
+     */
+    bool resume(const Position& at);
+
+private:
+    std::string path;
+    ExportFormat format;
+    long shardSize;
+    long inShard;   // molecules in the current shard
+    int numShards;
+    std::ofstream out;
+    std::string file;                 // the path out is open on
+    std::vector<std::string> written; // files written since listFiles last ran
+    bool failed;
+
+    // Matrix Market only: the molecule index, and the size of the matrix so far
+    std::ofstream index;
+    long rows, entries;
+    std::string text;
+
+    void openShard();
+    void writeMatrixMarket(const std::string& graph);
+};
+
+#endif
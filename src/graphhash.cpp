@@ -0,0 +1,263 @@
+/**
+ * File: graphhash.cpp
+ * -------------------
+ * This file contains the implementation for the GraphHash interface.
+ * Documentation for each method can be found in the graphhash.h file.
+ */
+
+#include <algorithm>
+#include <numeric>
+#include "graphhash.h"
+
+// gives up on an isomorphism search after this many steps per atom
+static const int SEARCH_STEPS_PER_ATOM = 100;
+
+// helper function declarations
+static int countDistinct(const uint64_t* values, uint64_t* sorted, int n);
+
+GraphHash::GraphHash() : natoms(0), nbonds(0), hash(0) {}
+
+GraphHash::GraphHash(const Molecule& mol) : natoms(0), nbonds(0), hash(0) {
+    compute(mol);
+}
+
+void GraphHash::compute(const Molecule& mol) {
+    ArrayView<Atom*> atoms = mol.getAtoms();
+    ArrayView<Bond*> bonds = mol.getBonds();
+    natoms = atoms.size();
+    nbonds = bonds.size();
+
+    labels.resize(natoms);
+    for (int i = 0; i < natoms; ++i) labels[i] = atomLabel(atoms[i]);
+
+    adjStart.assign(natoms + 1, 0);
+    for (int i = 0; i < nbonds; ++i) {
+        adjStart[bonds[i]->getFirstAtom()->getIndex() + 1]++;
+        adjStart[bonds[i]->getSecondAtom()->getIndex() + 1]++;
+    }
+    std::partial_sum(adjStart.begin(), adjStart.end(), adjStart.begin());
+    adjAtom.resize(adjStart[natoms]);
+    adjOrder.resize(adjStart[natoms]);
+    // the scratch space is per thread rather than per hash, since tables keep copies of hashes
+    static thread_local std::vector<int> fill;
+    static thread_local std::vector<uint64_t> work;
+    fill.assign(adjStart.begin(), adjStart.end() - 1);
+    for (int i = 0; i < nbonds; ++i) {
+        int a = bonds[i]->getFirstAtom()->getIndex();
+        int b = bonds[i]->getSecondAtom()->getIndex();
+        adjAtom[fill[a]] = b;
+        adjOrder[fill[a]++] = bonds[i]->getOrder();
+        adjAtom[fill[b]] = a;
+        adjOrder[fill[b]++] = bonds[i]->getOrder();
+    }
+
+    colors = labels;
+    refine(colors, work);
+    uint64_t multiset = 0;
+    for (uint64_t color : colors) multiset += mix(color);
+    hash = combine(combine(combine(0, natoms), nbonds), multiset);
+}
+
+uint64_t GraphHash::getHash() const {
+    return hash;
+}
+
+int GraphHash::getShard(int numShards) const {
+    return (hash >> 58) % numShards; // the hash is well mixed, so its top bits will do
+}
+
+const std::vector<uint64_t>& GraphHash::getColors() const {
+    return colors;
+}
+
+int GraphHash::getNumAtoms() const {
+    return natoms;
+}
+
+int GraphHash::getNumBonds() const {
+    return nbonds;
+}
+
+int GraphHash::bondOrder(int a, int b) const {
+    for (int k = adjStart[a]; k < adjStart[a + 1]; ++k) {
+        if (adjAtom[k] == b) return adjOrder[k];
+    }
+    return 0;
+}
+
+/*
+ * Weisfeiler-Lehman colour refinement: each round, an atom's new colour
+ * combines its old colour with the multiset of (neighbour colour, bond order)
+ * pairs. The multiset is folded with a commutative sum, so no sorting is
+ * needed. Refinement stops once a round no longer splits any colour class;
+ * isomorphic graphs stop after the same round and so get the same colours.
+ * The first half of work takes the next round's colours, the second a
+ * sorted copy for counting classes.
+ */
+void GraphHash::refine(std::vector<uint64_t>& colors, std::vector<uint64_t>& work) const {
+    work.resize(2 * natoms);
+    uint64_t* next = work.data();
+    uint64_t* sorted = work.data() + natoms;
+    int distinct = countDistinct(colors.data(), sorted, natoms);
+    for (int round = 0; round < natoms; ++round) {
+        for (int i = 0; i < natoms; ++i) {
+            uint64_t neighbourhood = 0;
+            for (int k = adjStart[i]; k < adjStart[i + 1]; ++k) {
+                neighbourhood += mix(combine(colors[adjAtom[k]], adjOrder[k]));
+            }
+            next[i] = combine(colors[i], neighbourhood);
+        }
+        std::copy(next, next + natoms, colors.begin());
+        int refined = countDistinct(colors.data(), sorted, natoms);
+        if (refined == distinct) break;
+        distinct = refined;
+    }
+}
+
+uint64_t GraphHash::atomLabel(Atom* atom) {
+    uint64_t label = std::hash<std::string>()(atom->getAbbreviation());
+    label = combine(label, atom->getCharge());
+    label = combine(label, atom->getIsotope());
+    return combine(label, atom->getHCount());
+}
+
+uint64_t GraphHash::mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+uint64_t GraphHash::combine(uint64_t seed, uint64_t value) {
+    return mix(seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
+/*
+ * Backtracking search for an isomorphism. Atoms are matched in breadth-first
+ * order starting from the rarest colour, so every atom after the first of a
+ * component only has to be tried against the neighbours of its parent's image.
+ * The search is iterative so that very large molecules cannot overflow the stack.
+ * Its arrays are slices of one buffer per thread, so checking a molecule
+ * against a table allocates nothing once the thread has seen one as large.
+ */
+bool GraphHash::isomorphism(const GraphHash& other, std::vector<int>& mapping) const {
+    if (natoms != other.natoms || nbonds != other.nbonds || hash != other.hash) return false;
+
+    static thread_local std::vector<int> scratch;
+    scratch.resize(7 * natoms);
+    int* byColor = scratch.data();
+    int* otherByColor = byColor + natoms;
+    int* roots = otherByColor + natoms;
+    int* order = roots + natoms;
+    int* parent = order + natoms;
+    int* reverse = parent + natoms;
+    int* next = reverse + natoms;
+
+    // colour class sizes, used to start each component from its rarest atom
+    std::iota(byColor, byColor + natoms, 0);
+    std::iota(otherByColor, otherByColor + natoms, 0);
+    std::sort(byColor, byColor + natoms, [&](int x, int y) {
+        return colors[x] < colors[y] || (colors[x] == colors[y] && x < y);
+    });
+    std::sort(otherByColor, otherByColor + natoms, [&](int x, int y) {
+        return other.colors[x] < other.colors[y] || (other.colors[x] == other.colors[y] && x < y);
+    });
+    auto colorRange = [&](uint64_t color) {
+        int* lo = std::lower_bound(otherByColor, otherByColor + natoms, color,
+                                   [&](int x, uint64_t c) { return other.colors[x] < c; });
+        int* hi = std::upper_bound(lo, otherByColor + natoms, color,
+                                   [&](uint64_t c, int x) { return c < other.colors[x]; });
+        return std::make_pair(int(lo - otherByColor), int(hi - otherByColor));
+    };
+    // rarest colour first; ties keep byColor's order, as a stable sort would
+    std::copy(byColor, byColor + natoms, roots);
+    std::sort(roots, roots + natoms, [&](int x, int y) {
+        std::pair<int, int> rx = colorRange(colors[x]), ry = colorRange(colors[y]);
+        int sx = rx.second - rx.first, sy = ry.second - ry.first;
+        return sx < sy || (sx == sy && (colors[x] < colors[y] || (colors[x] == colors[y] && x < y)));
+    });
+
+    // matching order and the parent each atom is reached from; reverse marks
+    // the atoms already visited until the search itself needs it
+    std::fill(parent, parent + natoms, -1);
+    std::fill(reverse, reverse + natoms, 0);
+    int ordered = 0;
+    for (int i = 0; i < natoms; ++i) {
+        int root = roots[i];
+        if (reverse[root]) continue;
+        reverse[root] = 1;
+        order[ordered++] = root;
+        for (int head = ordered - 1; head < ordered; ++head) {
+            int v = order[head];
+            for (int k = adjStart[v]; k < adjStart[v + 1]; ++k) {
+                int w = adjAtom[k];
+                if (reverse[w]) continue;
+                reverse[w] = 1;
+                parent[w] = v;
+                order[ordered++] = w;
+            }
+        }
+    }
+
+    std::fill(reverse, reverse + natoms, -1);
+    std::fill(next, next + natoms, 0);
+    mapping.assign(natoms, -1);
+    auto feasible = [&](int v, int t) {
+        if (colors[v] != other.colors[t] || reverse[t] != -1) return false;
+        for (int k = adjStart[v]; k < adjStart[v + 1]; ++k) {
+            int u = mapping[adjAtom[k]];
+            if (u != -1 && other.bondOrder(u, t) != adjOrder[k]) return false;
+        }
+        for (int k = other.adjStart[t]; k < other.adjStart[t + 1]; ++k) {
+            int u = reverse[other.adjAtom[k]];
+            if (u != -1 && bondOrder(v, u) != other.adjOrder[k]) return false;
+        }
+        return true;
+    };
+
+    long steps = 0, maxSteps = long(SEARCH_STEPS_PER_ATOM) * natoms + 1000;
+    int depth = 0;
+    while (depth >= 0 && depth < natoms) {
+        if (++steps > maxSteps) return false;
+        int v = order[depth];
+        if (mapping[v] != -1) { // retrying this atom: undo its previous image
+            reverse[mapping[v]] = -1;
+            mapping[v] = -1;
+        }
+        int first, last;
+        if (parent[v] != -1) {
+            first = other.adjStart[mapping[parent[v]]];
+            last = other.adjStart[mapping[parent[v]] + 1];
+        } else {
+            std::pair<int, int> range = colorRange(colors[v]);
+            first = range.first;
+            last = range.second;
+        }
+        bool matched = false;
+        while (first + next[depth] < last) {
+            int k = first + next[depth]++;
+            int t = parent[v] != -1 ? other.adjAtom[k] : otherByColor[k];
+            if (feasible(v, t)) {
+                mapping[v] = t;
+                reverse[t] = v;
+                matched = true;
+                break;
+            }
+        }
+        if (matched) {
+            depth++;
+            if (depth < natoms) next[depth] = 0;
+        } else {
+            depth--;
+        }
+    }
+    return depth == natoms;
+}
+
+static int countDistinct(const uint64_t* values, uint64_t* sorted, int n) {
+    std::copy(values, values + n, sorted);
+    std::sort(sorted, sorted + n);
+    return std::unique(sorted, sorted + n) - sorted;
+}
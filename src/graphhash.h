@@ -0,0 +1,158 @@
+/**
+ * File: graphhash.h
+ * -----------------
+ * This file contains the interface for the GraphHash class.
+ * A GraphHash is a compact snapshot of a Molecule's labelled graph
+ * (element, charge, isotope and hydrogen count on the atoms, order
+ * on the bonds) together with a Weisfeiler-Lehman hash of it.
+ * Isomorphic molecules always hash alike whatever their atom order;
+ * since different molecules can occasionally collide, the snapshot
+ * also supports an exact isomorphism check that returns the atom
+ * mapping between the two graphs.
+ */
+
+#ifndef _graphhash_h
+#define _graphhash_h
+
+#include <cstdint>
+#include <vector>
+#include "molecule.h"
+
+class GraphHash {
+public:
+    /**
+     * Constructor: GraphHash
+     * Usage: GraphHash hash;
+     * ----------------------
+     * Initializes the hash of an empty graph.
+     */
+    GraphHash();
+
+    /**
+     * Constructor: GraphHash
+     * Parameters: mol
+     * Usage: GraphHash hash(mol);
+     * ---------------------------
+     * Takes a snapshot of the molecule's graph and hashes it.
+     */
+    GraphHash(const Molecule& mol);
+
+    /**
+     * Function: compute
+     * Parameters: mol
+     * Usage: hash.compute(mol);
+     * -------------------------
+     * Takes a snapshot of the molecule's graph and hashes it, replacing any
+     * previous snapshot.
+     */
+    void compute(const Molecule& mol);
+
+    /**
+     * Function: getHash
+     * Usage: uint64_t key = hash.getHash();
+     * -------------------------------------
+     * Returns the 64-bit Weisfeiler-Lehman hash of the whole graph.
+     */
+    uint64_t getHash() const;
+
+    /**
+     * Function: getShard
+     * Parameters: numShards
+     * Usage: Shard& shard = shards[graph.getShard(NUM_SHARDS)];
+     * ---------------------------------------------------------
+     * Returns which of numShards shards (at most 64) a table split into
+     * independently locked parts should keep this graph in.
+     */
+    int getShard(int numShards) const;
+
+    /**
+     * Function: getColors
+     * Usage: const std::vector<uint64_t>& colors = hash.getColors();
+     * --------------------------------------------------------------
+     * Returns the refined colour of each atom. Atoms with different colours
+     * can never be mapped onto each other by an isomorphism.
+     */
+    const std::vector<uint64_t>& getColors() const;
+
+    /**
+     * Function: getNumAtoms
+     * Usage: int n = hash.getNumAtoms();
+     * ----------------------------------
+     * Returns the number of atoms in the snapshot.
+     */
+    int getNumAtoms() const;
+
+    /**
+     * Function: getNumBonds
+     * Usage: int m = hash.getNumBonds();
+     * ----------------------------------
+     * Returns the number of bonds in the snapshot.
+     */
+    int getNumBonds() const;
+
+    /**
+     * Function: isomorphism
+     * Parameters: other, mapping
+     * Usage: if (hash.isomorphism(other, mapping)) {...}
+     * --------------------------------------------------
+     * Returns true if the two labelled graphs are isomorphic, in which case
+     * mapping[i] is the atom of other that atom i of this graph maps onto.
+     * The search is guided by the refined colours and gives up (returning
+     * false) after a fixed number of steps on pathologically symmetric graphs.
+     */
+    bool isomorphism(const GraphHash& other, std::vector<int>& mapping) const;
+
+    /**
+     * Function: bondOrder
+     * Parameters: a, b
+     * Usage: int order = hash.bondOrder(a, b);
+     * ----------------------------------------
+     * Returns the order of the bond between atoms a and b, or 0 if none.
+     */
+    int bondOrder(int a, int b) const;
+
+    /**
+     * Function: refine
+     * Parameters: colors, work
+     * Usage: hash.refine(colors, work);
+     * ---------------------------------
+     * Refines colours of the snapshot's atoms the way getColors was found,
+     * until a round splits no colour class. Starting from getColors with a
+     * few atoms recoloured individualizes those atoms. work is scratch space
+     * that the caller may keep between calls.
+     */
+    void refine(std::vector<uint64_t>& colors, std::vector<uint64_t>& work) const;
+
+    /**
+     * Function: atomLabel
+     * Parameters: atom
+     * Usage: uint64_t label = GraphHash::atomLabel(atom);
+     * ---------------------------------------------------
+     * Returns the hash of the atom's element, charge, isotope and hydrogen
+     * count, which is the colour refinement starts from.
+     */
+    static uint64_t atomLabel(Atom* atom);
+
+    /**
+     * Functions: mix, combine
+     * Usage: uint64_t value = GraphHash::combine(seed, GraphHash::mix(x));
+     * --------------------------------------------------------------------
+     * The hashing the colours are made with: mix is the splitmix64 finalizer,
+     * a cheap bijective mixer that spreads every input bit over the whole
+     * word, and combine folds a value into a seed.
+     */
+    static uint64_t mix(uint64_t x);
+    static uint64_t combine(uint64_t seed, uint64_t value);
+
+private:
+    // labelled graph in compressed adjacency form
+    int natoms, nbonds;
+    std::vector<uint64_t> labels;
+    std::vector<int> adjStart, adjAtom, adjOrder;
+
+    // Weisfeiler-Lehman results
+    std::vector<uint64_t> colors;
+    uint64_t hash;
+};
+
+#endif
@@ -5,13 +5,27 @@
  * Documentation for each method can be found in the molecule.h file.
  */
 
-#include "stack.h"
-#include "map.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include "error.h"
+#include "trace.h"
 #include "molecule.h"
 
-bool isDigit(const char& c){
-   return c >= '0' && c <= '9';
-}
+// helper function declaration (defined in atom.cpp)
+bool isDigit(const char& c);
+
+// SMILES ring numbers are a single digit or '%' and two digits
+static const int NUM_RING_NUMBERS = 100;
+
+// helper function declarations
+static bool isLetter(char c);
+static bool isBondSymbol(char c);
+static bool isSmilesSpace(char c);
+static bool isOrganic(char c);
+static bool isTwoLetterOrganic(const char* smiles, size_t strpos, size_t length);
+static bool checkBracketAtom(const char* smiles, size_t& strpos, size_t close);
+static int bondOrder(char bond);
 
 Molecule::Molecule() {}
 
@@ -19,96 +33,243 @@ Molecule::Molecule(const std::string& smiles) {
     smilesToMolecule(smiles); // sets all properties in the molecule
 }
 
+Molecule::Molecule(MolArena* memory) : arena(memory) {}
+
+Molecule::Molecule(Molecule&& other) noexcept :
+    atoms(std::move(other.atoms)),
+    bonds(std::move(other.bonds)),
+    arena(other.arena),
+    ringClosures(std::move(other.ringClosures)),
+    branches(std::move(other.branches)),
+    chainParent(std::move(other.chainParent)),
+    ringBonds(std::move(other.ringBonds)),
+    periodicTable(std::move(other.periodicTable)) {
+    other.atoms.clear();
+    other.bonds.clear();
+}
+
+Molecule& Molecule::operator=(Molecule&& other) noexcept {
+    if (this != &other) {
+        clear();
+        atoms.swap(other.atoms);
+        bonds.swap(other.bonds);
+        arena = other.arena;
+        ringClosures.swap(other.ringClosures);
+        branches.swap(other.branches);
+        chainParent.swap(other.chainParent);
+        ringBonds.swap(other.ringBonds);
+        periodicTable = std::move(other.periodicTable);
+    }
+    return *this;
+}
+
 Molecule::~Molecule() {
-    // deletes any dynamically allocated atoms and bonds
-    for (const Atom * atom : atoms) delete atom;
-    for (const Bond * bond : bonds) delete bond;
+    clear();
+}
+
+void Molecule::clear() {
+    truncate(0, 0);
+}
+
+void Molecule::truncate(size_t numAtoms, size_t numBonds) {
+    for (size_t i = numAtoms; i < atoms.size(); ++i) {
+        if (arena != nullptr) { // the arena's owner frees the memory in bulk
+            atoms[i]->~Atom();
+        } else { // deletes any dynamically allocated atoms
+            delete atoms[i];
+        }
+    }
+    for (size_t i = numBonds; i < bonds.size(); ++i) {
+        if (arena != nullptr) {
+            bonds[i]->~Bond();
+        } else {
+            delete bonds[i];
+        }
+    }
+    atoms.resize(numAtoms);
+    bonds.resize(numBonds);
+}
+
+Atom* Molecule::newAtom() {
+    return arena != nullptr ? arena->create<Atom>() : new Atom();
+}
+
+Bond* Molecule::newBond(Atom * one, Atom * two) {
+    return arena != nullptr ? arena->create<Bond>(one, two) : new Bond(one, two);
 }
 
 void Molecule::addAtom(Atom * atom) {
-    atoms.add(atom);
+    atom->setIndex(atoms.size());
+    atoms.push_back(atom);
 }
-Vector<Atom*> Molecule::getAtoms() const {
-    return atoms;
+ArrayView<Atom*> Molecule::getAtoms() const {
+    return ArrayView<Atom*>(atoms.data(), atoms.size());
 }
 
 void Molecule::addBond(Bond * bond) {
-    bonds.add(bond);
+    bonds.push_back(bond);
+}
+ArrayView<Bond*> Molecule::getBonds() const {
+    return ArrayView<Bond*>(bonds.data(), bonds.size());
 }
-Vector<Bond*> Molecule::getBonds() const {
-    return bonds;
+
+void Molecule::addFragment(const Molecule& source, const Vector<int>& fragment) {
+    std::vector<Atom*> copies(source.atoms.size(), nullptr); // copy of each source atom, if taken
+    for (int i : fragment) {
+        Atom * copy = newAtom();
+        *copy = *source.atoms[i];
+        copies[i] = copy;
+        addAtom(copy);
+    }
+    for (Bond * bond : source.bonds) {
+        Atom * one = copies[bond->getFirstAtom()->getIndex()];
+        Atom * two = copies[bond->getSecondAtom()->getIndex()];
+        if (one == nullptr || two == nullptr) continue;
+        Bond * copy = newBond(one, two);
+        copy->setOrder(bond->getOrder());
+        addBond(copy);
+    }
 }
 
 void Molecule::smilesToMolecule(const std::string& smiles) {
+    smilesToMolecule(smiles.data(), smiles.size());
+}
+
+void Molecule::smilesToMolecule(const char* smiles, size_t length) {
+    SmilesError problem;
+    if (!parseSmiles(smiles, length, problem)) {
+        error("Invalid SMILES at position " + integerToString(problem.offset) + ": " + problem.reason);
+    }
+}
+
+bool Molecule::parseSmiles(const char* smiles, size_t length, SmilesError& problem) {
+    size_t firstAtom = atoms.size(), firstBond = bonds.size();
+    auto reject = [&](size_t offset, const std::string& reason) {
+        truncate(firstAtom, firstBond); // leaves the molecule as it was
+        problem.offset = offset;
+        problem.reason = reason;
+        return false;
+    };
+
+    TraceSpan span("parse");
+    span.setArg("bytes", length);
+    length = std::find_if(smiles, smiles + length, isSmilesSpace) - smiles; // anything after it is a name
+    if (length == 0) return reject(0, "empty SMILES");
+    ringClosures.assign(NUM_RING_NUMBERS, RingOpening{nullptr, 0, 0});
+    branches.clear();
+    chainParent.clear();
+    ringBonds.clear();
+    Atom * prevAtom = nullptr; // the atom the next atom bonds to (null at the start and after '.')
+    char bond = 0;             // bond symbol waiting for its second atom
+    size_t bondPos = 0, dotPos = 0;
     size_t strpos = 0;
-    Map<int, Atom*> ringClosures; // maps a ring closure to its original atom
-    Stack<Atom*> branches; // top element contains the atom right before the most recent branch
-    while (strpos < smiles.size()) {
-        Atom * prevAtom = nullptr;
-        if (!atoms.isEmpty()) {
-            prevAtom = atoms.back();
-        }
-        while (smiles[strpos] == ')') { // CHECK FOR CLOSING BRANCHES FIRST
-            prevAtom = branches.pop();
-            strpos++;
-            if (strpos == smiles.size()) break; // if a branch close is the end of the molecule
-        }
-        if (isalpha(smiles[strpos]) || smiles[strpos] == '[') { // ATOMS
-            Atom * curr = new Atom();
-            size_t copyStrpos = strpos; // useful if the atom's information is longer than one character
-            if (isalpha(smiles[strpos])) { // normal atom
-                if (strpos + 1 < smiles.size() && isalpha(smiles[strpos + 1]) &&
-                        periodicTable.containsKey(smiles.substr(strpos, 2))) { // two-letter element
-                    curr->setToken(smiles.substr(strpos, 2));
-                } else { // one-letter element
-                    curr->setToken(charToString(smiles[strpos]));
+    while (strpos < length) {
+        char c = smiles[strpos];
+        if (isLetter(c) || c == '[' || c == '*') { // ATOMS
+            size_t tokenPos = strpos, tokenLength;
+            if (c == '[') { // SPECIAL ATOM (isotope, chiral, stereo...)
+                const char* found = static_cast<const char*>(std::memchr(smiles + strpos, ']', length - strpos));
+                if (found == nullptr) return reject(strpos, "'[' without a matching ']'");
+                size_t close = found - smiles;
+                size_t bad = strpos + 1;
+                if (!checkBracketAtom(smiles, bad, close)) return reject(bad, "malformed bracket atom");
+                tokenPos = strpos + 1;
+                tokenLength = close - strpos - 1;
+                strpos = close + 1;
+            } else { // normal atom from the organic subset
+                tokenLength = isTwoLetterOrganic(smiles, strpos, length) ? 2 : 1;
+                if (tokenLength == 1 && !isOrganic(c)) {
+                    return reject(strpos, std::string("'") + c + "' must be written in brackets");
                 }
-            } else { // SPECIAL ATOM (isotope, chiral, stereo...)
-                size_t temp = smiles.find(']', strpos);
-                std::string token = smiles.substr(strpos + 1, temp - strpos - 1);
-                curr->setToken(token);
-                strpos = temp;
+                strpos += tokenLength;
             }
+            Atom * curr = newAtom();
+            curr->setToken(std::string(smiles + tokenPos, tokenLength));
             curr->setAllSpecials();
-            atoms.add(curr);
-            if (prevAtom != nullptr) { // if not the first atom
-                Bond * bond = new Bond(prevAtom, curr);
-                if (smiles[copyStrpos - 1] == '-' ||
-                        smiles[copyStrpos - 1] == '=' ||
-                        smiles[copyStrpos - 1] == '#') {
-                    bond->setOrder(smiles[copyStrpos - 1]);
-                }
-                bonds.add(bond);
+            curr->setBracket(c == '[');
+            addAtom(curr);
+            chainParent.push_back(prevAtom != nullptr ? prevAtom->getIndex() : -1);
+            if (prevAtom != nullptr) { // if not the first atom of a component
+                Bond * edge = newBond(prevAtom, curr);
+                if (bond != 0) edge->setOrder(bond);
+                addBond(edge);
             }
-        } else if (isDigit(smiles[strpos]) || smiles[strpos] == '%') { // RING CLOSURES
+            prevAtom = curr;
+            bond = 0;
+        } else if (isBondSymbol(c)) { // BONDS
+            if (prevAtom == nullptr) return reject(strpos, "bond symbol without an atom before it");
+            if (bond != 0) return reject(strpos, "two bond symbols in a row");
+            if (c == '$') return reject(strpos, "quadruple bonds are not supported");
+            bond = c;
+            bondPos = strpos++;
+        } else if (isDigit(c) || c == '%') { // RING CLOSURES
+            if (prevAtom == nullptr) return reject(strpos, "ring number without an atom before it");
+            size_t ringPos = strpos;
             int ringClosure;
-            if (smiles[strpos] == '%') {
-                std::string temp;
-                while (isDigit(smiles[strpos + 1])) {
-                    temp += smiles[strpos + 1];
-                    strpos++;
+            if (c == '%') {
+                if (strpos + 2 >= length || !isDigit(smiles[strpos + 1]) || !isDigit(smiles[strpos + 2])) {
+                    return reject(strpos, "'%' must be followed by two digits");
                 }
-                ringClosure = stringToInteger(temp);
+                ringClosure = charToInteger(smiles[strpos + 1]) * 10 + charToInteger(smiles[strpos + 2]);
+                strpos += 3;
             } else {
-                ringClosure = charToInteger(smiles[strpos]);
+                ringClosure = charToInteger(c);
+                strpos++;
             }
-            // if the ringClosure already exists --> finish the closure
-            if (ringClosures.containsKey(ringClosure)) {
-                Bond * bond = new Bond(ringClosures[ringClosure], atoms.back());
-                if (smiles[strpos - 1] == '-' ||
-                        smiles[strpos - 1] == '=' ||
-                        smiles[strpos - 1] == '#') {
-                    bond->setOrder(smiles[strpos - 1]);
+            RingOpening& ring = ringClosures[ringClosure];
+            if (ring.atom == nullptr) { // opens the ring
+                ring = RingOpening{prevAtom, ringPos, bond};
+            } else { // finishes the closure; ring numbers may be reused
+                if (ring.atom == prevAtom) return reject(ringPos, "ring closed on the atom that opened it");
+                if (bond != 0 && ring.bond != 0 && bondOrder(bond) != bondOrder(ring.bond)) {
+                    return reject(ringPos, "ring bond symbols disagree");
                 }
-                bonds.add(bond);
-            } else {
-               ringClosures.add(ringClosure, atoms.back());
+                // an earlier atom is bonded to a later one either along the chain or by a ring bond
+                int one = std::min(ring.atom->getIndex(), prevAtom->getIndex());
+                int two = std::max(ring.atom->getIndex(), prevAtom->getIndex());
+                bool bonded = chainParent[two - firstAtom] == one;
+                for (size_t i = 0; !bonded && i < ringBonds.size(); ++i) {
+                    bonded = ringBonds[i] == std::make_pair(one, two);
+                }
+                if (bonded) return reject(ringPos, "ring bond duplicates an existing bond");
+                ringBonds.push_back(std::make_pair(one, two));
+                Bond * edge = newBond(ring.atom, prevAtom);
+                if (bond != 0 || ring.bond != 0) edge->setOrder(bond != 0 ? bond : ring.bond);
+                addBond(edge);
+                ring.atom = nullptr;
             }
-        } else if (smiles[strpos] == '(') {
-            branches.push(atoms.back());
+            bond = 0;
+        } else if (c == '(') { // BRANCHES
+            if (prevAtom == nullptr) return reject(strpos, "branch without an atom before it");
+            if (bond != 0) return reject(bondPos, "bond symbol before a branch");
+            branches.push_back(BranchOpening{prevAtom, strpos++});
+        } else if (c == ')') {
+            if (branches.empty()) return reject(strpos, "')' without a matching '('");
+            if (bond != 0) return reject(bondPos, "bond symbol without an atom after it");
+            if (smiles[strpos - 1] == '(') return reject(strpos, "empty branch");
+            prevAtom = branches.back().atom; // the next atom hangs off the branch point again
+            branches.pop_back();
+            strpos++;
+        } else if (c == '.') { // DISCONNECTED COMPONENTS
+            if (prevAtom == nullptr) return reject(strpos, "'.' without an atom before it");
+            if (bond != 0) return reject(bondPos, "bond symbol without an atom after it");
+            prevAtom = nullptr;
+            dotPos = strpos++;
+        } else if (c == ']') {
+            return reject(strpos, "']' without a matching '['");
+        } else {
+            return reject(strpos, std::string("unexpected character '") + c + "'");
         }
-        strpos++;
     }
+    if (bond != 0) return reject(bondPos, "bond symbol without an atom after it");
+    if (prevAtom == nullptr) return reject(dotPos, "'.' without an atom after it");
+    if (!branches.empty()) return reject(branches.back().offset, "'(' without a matching ')'");
+    for (const RingOpening& ring : ringClosures) {
+        if (ring.atom != nullptr) return reject(ring.offset, "ring number is never closed");
+    }
+    span.setArg("atoms", atoms.size() - firstAtom);
+    span.setArg("bonds", bonds.size() - firstBond);
+    return true;
 }
 
 void Molecule::printMolecule() {
@@ -117,12 +278,116 @@ void Molecule::printMolecule() {
     std::cout << "Number of bonds: " << bonds.size() << std::endl;
 
     std::cout << "ATOM BLOCK" << std::endl;
-    for (int i = 0; i < atoms.size(); ++i) {
+    for (size_t i = 0; i < atoms.size(); ++i) {
         std::cout << "Atom " << i << ": " << atoms[i]->getAbbreviation() << std::endl;
     }
     std::cout << "BOND BLOCK" << std::endl;
-    for (int i = 0; i < bonds.size(); ++i) {
-        std::cout << "Bond " << i << ": " << atoms.indexOf(bonds[i]->getFirstAtom()) <<
-                     "\t" << atoms.indexOf(bonds[i]->getSecondAtom()) << std::endl;
+    for (size_t i = 0; i < bonds.size(); ++i) {
+        std::cout << "Bond " << i << ": " << bonds[i]->getFirstAtom()->getIndex() <<
+                     "\t" << bonds[i]->getSecondAtom()->getIndex() << std::endl;
+    }
+}
+
+/*
+ * Returns the order of the bond a symbol stands for; aromatic and
+ * directional bonds count as single, as in Bond::setOrder.
+ */
+static int bondOrder(char bond) {
+    return bond == '=' ? 2 : bond == '#' ? 3 : 1;
+}
+
+/*
+ * Returns true for an ASCII letter; bytes above 0x7F never are.
+ */
+static bool isLetter(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+static bool isBondSymbol(char c) {
+    switch (c) {
+    case '-': case '=': case '#': case '$': case ':': case '/': case '\\':
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*
+ * Returns true for the whitespace that ends a SMILES string.
+ */
+static bool isSmilesSpace(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/*
+ * Returns true for the one-letter elements that may be written without
+ * brackets: the organic subset, its aromatic forms, and the '*' wildcard.
+ */
+static bool isOrganic(char c) {
+    switch (c) {
+    case 'B': case 'C': case 'N': case 'O': case 'P': case 'S': case 'F': case 'I':
+    case 'b': case 'c': case 'n': case 'o': case 'p': case 's': case '*':
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool isTwoLetterOrganic(const char* smiles, size_t strpos, size_t length) {
+    if (strpos + 1 >= length) return false;
+    return (smiles[strpos] == 'C' && smiles[strpos + 1] == 'l') ||
+           (smiles[strpos] == 'B' && smiles[strpos + 1] == 'r');
+}
+
+/*
+ * Checks the contents of a bracket atom, smiles[strpos, close), against
+ *     isotope? symbol chirality? hydrogens? charge? class?
+ * Returns false, with strpos at the first byte that does not fit, if they
+ * do not.
+ */
+static bool checkBracketAtom(const char* smiles, size_t& strpos, size_t close) {
+    size_t start = strpos;
+    while (strpos < close && strpos - start < 3 && isDigit(smiles[strpos])) strpos++; // isotope
+    if (strpos == close) return false; // no element symbol
+    if (isupper((unsigned char) smiles[strpos])) { // element symbol
+        strpos++;
+        if (strpos < close && islower((unsigned char) smiles[strpos])) strpos++;
+    } else if (strpos + 1 < close && (std::string(smiles + strpos, 2) == "se" ||
+                                      std::string(smiles + strpos, 2) == "as" ||
+                                      std::string(smiles + strpos, 2) == "te")) {
+        strpos += 2;
+    } else if (isOrganic(smiles[strpos])) { // aromatic atom or wildcard
+        strpos++;
+    } else {
+        return false;
+    }
+    if (strpos < close && smiles[strpos] == '@') { // chirality: @, @@, or a class like @TH1
+        strpos++;
+        if (strpos < close && smiles[strpos] == '@') {
+            strpos++;
+        } else if (strpos + 2 < close && isupper((unsigned char) smiles[strpos]) &&
+                   isupper((unsigned char) smiles[strpos + 1]) && isDigit(smiles[strpos + 2])) {
+            strpos += 3;
+            if (strpos < close && isDigit(smiles[strpos])) strpos++;
+        }
+    }
+    if (strpos < close && smiles[strpos] == 'H') { // hydrogen count
+        strpos++;
+        if (strpos < close && isDigit(smiles[strpos])) strpos++;
+    }
+    if (strpos < close && (smiles[strpos] == '+' || smiles[strpos] == '-')) { // charge: +, ++, +2...
+        char sign = smiles[strpos++];
+        if (strpos < close && isDigit(smiles[strpos])) {
+            strpos++;
+            if (strpos < close && isDigit(smiles[strpos])) strpos++;
+        } else {
+            while (strpos < close && smiles[strpos] == sign) strpos++;
+        }
+    }
+    if (strpos < close && smiles[strpos] == ':') { // atom class
+        strpos++;
+        if (strpos == close || !isDigit(smiles[strpos])) return false;
+        while (strpos < close && isDigit(smiles[strpos])) strpos++;
     }
+    return strpos == close;
 }
@@ -7,11 +7,29 @@
  * relation to one another.
  */
 
+#ifndef _molecule_h
+#define _molecule_h
+
 #include <string>
+#include <vector>
 #include "vector.h"
 #include "map.h"
+#include "arrayview.h"
+#include "arena.h"
 #include "bond.h"
 
+/**
+ * Struct: SmilesError
+ * -------------------
+ * Why a SMILES string was rejected: the byte offset of the problem in the
+ * string and a short reason. Callers reading SMILES from a file fill in
+ * the line number.
+ */
+struct SmilesError {
+    long line = 0;
+    size_t offset = 0;
+    std::string reason;
+};
 
 class Molecule {
 public:
@@ -33,6 +51,42 @@ public:
      */
     Molecule(const std::string& smiles);
 
+    /**
+     * Constructor: Molecule
+     * Parameters: arena
+     * Usage: Molecule mol(&arena);
+     * ----------------------------
+     * Initializes a new Molecule object whose parsed atoms and bonds are
+     * placed in the arena instead of on the heap. The molecule destroys them
+     * but never frees them; the owner of the arena resets it after the
+     * molecule has been cleared or destroyed. Atoms and bonds passed to
+     * addAtom or addBond must then come from the same arena.
+     */
+    Molecule(MolArena* arena);
+
+    /**
+     * Constructor: Molecule
+     * Parameters: other
+     * Usage: Molecule mol(std::move(other));
+     * --------------------------------------
+     * Takes over the atoms and bonds of other, leaving it empty.
+     * Molecules own their atoms and bonds, so they can be moved but not copied.
+     */
+    Molecule(Molecule&& other) noexcept;
+
+    /**
+     * Operator: =
+     * Parameters: other
+     * Usage: mol = std::move(other);
+     * ------------------------------
+     * Deletes this molecule's atoms and bonds and takes over those of other,
+     * leaving it empty.
+     */
+    Molecule& operator=(Molecule&& other) noexcept;
+
+    Molecule(const Molecule&) = delete;
+    Molecule& operator=(const Molecule&) = delete;
+
     /**
      * Destructor: ~Molecule
      * Usage: delete mol;
@@ -46,17 +100,18 @@ public:
      * Parameters: atom
      * Usage: mol.addAtom(atom);
      * -------------------------
-     * Adds a new atom to the molecule object.
+     * Adds a new atom to the molecule object and records its index.
      */
     void addAtom(Atom* atom);
 
     /**
      * Function: getAtoms
-     * Usage: Vector<Atom*> atoms = mol.getAtoms();
-     * --------------------------------------------
-     * Returns the atoms in the molecule.
+     * Usage: ArrayView<Atom*> atoms = mol.getAtoms();
+     * -----------------------------------------------
+     * Returns a view of the atoms in the molecule, in index order. The view
+     * does not copy the atoms and is valid until the molecule changes.
      */
-    Vector<Atom*> getAtoms() const;
+    ArrayView<Atom*> getAtoms() const;
 
     /**
      * Function: addBond
@@ -69,11 +124,46 @@ public:
 
     /**
      * Function: getBonds
-     * Usage: Vector<Bond*> bonds = mol.getBonds();
-     * --------------------------------------------
-     * Returns the bonds in the molecule.
+     * Usage: ArrayView<Bond*> bonds = mol.getBonds();
+     * -----------------------------------------------
+     * Returns a view of the bonds in the molecule. The view does not copy
+     * the bonds and is valid until the molecule changes.
      */
-    Vector<Bond*> getBonds() const;
+    ArrayView<Bond*> getBonds() const;
+
+    /**
+     * Function: clear
+     * Usage: mol.clear();
+     * -------------------
+     * Removes and destroys every atom and bond, keeping the molecule's own
+     * storage so the next SMILES string can be parsed into it without
+     * allocating.
+     */
+    void clear();
+
+    /**
+     * Function: addFragment
+     * Parameters: source, fragment
+     * Usage: mol.addFragment(source, atoms);
+     * --------------------------------------
+     * Adds copies of the listed atoms of source, in the order listed, and of
+     * every bond of source between two of them, in source's bond order.
+     * Atom properties such as hydrogen counts are copied unchanged.
+     */
+    void addFragment(const Molecule& source, const Vector<int>& fragment);
+
+    /**
+     * Function: parseSmiles
+     * Parameters: smiles, length, problem
+     * Usage: if (!mol.parseSmiles(buffer, length, problem)) {...}
+     * ----------------------------------------------------------
+     * Validates and parses the first length bytes of a SMILES buffer in a
+     * single pass, adding its atoms and bonds to the molecule as a new
+     * component. Parsing stops at the first whitespace character. If the
+     * SMILES is malformed, the molecule is left as it was, problem records
+     * where and why, and false is returned; nothing is thrown.
+     */
+    bool parseSmiles(const char* smiles, size_t length, SmilesError& problem);
 
     /**
      * Function: smilesToMolecule
@@ -81,9 +171,21 @@ public:
      * Usage: mol.smilestoMolecule(smiles);
      * ------------------------------------
      * Parses a SMILES string and adds all of the features of the SMILES into the molecule object.
+     * Calls error() if the SMILES is malformed.
      */
     void smilesToMolecule(const std::string& smiles);
 
+    /**
+     * Function: smilesToMolecule
+     * Parameters: smiles, length
+     * Usage: mol.smilesToMolecule(buffer, length);
+     * --------------------------------------------
+     * Parses the first length bytes of a SMILES buffer, which need not be
+     * null-terminated. Parsing stops at the first whitespace character.
+     * Calls error() if the SMILES is malformed.
+     */
+    void smilesToMolecule(const char* smiles, size_t length);
+
     /**
      * Function: printMolecule
      * Usage: mol.printMolecule()
@@ -93,12 +195,38 @@ public:
     void printMolecule();
 
 private:
-    // holds all of the atoms in the molecule
-    Vector<Atom*> atoms;
+    // holds all of the atoms in the molecule (contiguous, so they can be viewed)
+    std::vector<Atom*> atoms;
 
     // holds all of the bonds in the molecule
-    Vector<Bond*> bonds;
+    std::vector<Bond*> bonds;
+
+    // where parsed atoms and bonds are allocated (not owned; heap if null)
+    MolArena* arena = nullptr;
+
+    // where a ring number or a branch was opened
+    struct RingOpening {
+        Atom* atom;    // null while the ring number is not in use
+        size_t offset;
+        char bond;     // bond symbol written before the ring number, if any
+    };
+    struct BranchOpening {
+        Atom* atom;    // the atom the branch hangs off
+        size_t offset;
+    };
+
+    // parser scratch space, kept between calls to parseSmiles
+    std::vector<RingOpening> ringClosures; // by ring number
+    std::vector<BranchOpening> branches;
+    std::vector<int> chainParent;               // by atom index: the atom it was bonded to when read, or -1
+    std::vector<std::pair<int, int>> ringBonds; // atoms joined by each ring bond closed so far
+
+    Atom* newAtom();
+    Bond* newBond(Atom* one, Atom* two);
+    void truncate(size_t numAtoms, size_t numBonds);
 
     // holds all of the elements and their features
     Map<std::string, Vector<std::string>> periodicTable;
 };
+
+#endif
@@ -5,7 +5,11 @@
  * Documentation for each method can be found in the molgraph.h file.
  */
 
+#include <algorithm>
+#include <cmath>
+#include "fiedler.h"
 #include "molgraph.h"
+#include "trace.h"
 
 MolGraph::MolGraph() {}
 
@@ -13,45 +17,186 @@ MolGraph::MolGraph(Molecule& mol) {
     moleculeToGraph(mol);
 }
 
+MolGraph::MolGraph(Molecule& mol, SpectrumCache* spectra) {
+    cache = spectra;
+    moleculeToGraph(mol);
+}
+
+MolGraph::MolGraph(Molecule& mol, PartitionBackend partitioner, SpectrumCache* spectra) {
+    backend = partitioner;
+    cache = spectra;
+    moleculeToGraph(mol);
+}
+
+MolGraph::MolGraph(PartitionBackend partitioner, SpectrumCache* spectra) {
+    backend = partitioner;
+    cache = spectra;
+}
+
 MolGraph::~MolGraph() {}
 
 void MolGraph::moleculeToGraph(Molecule& mol) {
-    Vector<Atom*> atoms = mol.getAtoms();
-    Vector<Bond*> bonds = mol.getBonds();
-    // make the adjacency matrix
-    wAdjacency = arma::zeros(atoms.size(), atoms.size());
-    for (int i = 0; i < bonds.size(); ++i) {
-        int row = atoms.indexOf(bonds[i]->getFirstAtom());
-        int col = atoms.indexOf(bonds[i]->getSecondAtom());
-        wAdjacency(row, col) = wAdjacency(col, row) = bonds[i]->getOrder();
-    }
+    convert(mol, nullptr);
+}
+
+void MolGraph::moleculeToGraph(Molecule& mol, const GraphHash& hash) {
+    convert(mol, &hash);
+}
+
+/*
+ * Does the work of both versions of moleculeToGraph; hash is null when the
+ * molecule still has to be hashed.
+ */
+void MolGraph::convert(Molecule& mol, const GraphHash* hash) {
+    ArrayView<Atom*> atoms = mol.getAtoms();
+    ArrayView<Bond*> bonds = mol.getBonds();
 
-    // make the degree matrix
-    degree = arma::zeros(atoms.size(), atoms.size());
+    // find the ring systems, which must not be split
+    {
+        TraceSpan span("rings");
+        span.setArg("atoms", atoms.size());
+        span.setArg("bonds", bonds.size());
+        rings.perceive(mol);
+    }
+    numRingSystems = rings.getNumRingSystems();
+    ringSystem.clear();
     for (int i = 0; i < atoms.size(); ++i) {
-        int sum = 0;
-        for (int j = 0; j < atoms.size(); ++j) {
-            sum += wAdjacency(i, j);
+        ringSystem.add(rings.getRingSystem(i));
+    }
+
+    // the multilevel partitioner never builds the dense matrices
+    fiedler.clear();
+    eigenvalues.clear();
+    partition.clear();
+    if (backend == MultilevelBackend) {
+        TraceSpan span("partition");
+        span.setArg("atoms", atoms.size());
+        span.setArg("bonds", bonds.size());
+        partitioner.partition(mol, rings, partition);
+        degree.reset();
+        wAdjacency.reset();
+        laplacian.reset();
+        return;
+    }
+
+    // build the matrices
+    {
+        TraceSpan span("graph");
+        span.setArg("atoms", atoms.size());
+        span.setArg("bonds", bonds.size());
+
+        // make the adjacency matrix
+        wAdjacency.zeros(atoms.size(), atoms.size());
+        for (int i = 0; i < bonds.size(); ++i) {
+            int row = bonds[i]->getFirstAtom()->getIndex();
+            int col = bonds[i]->getSecondAtom()->getIndex();
+            wAdjacency(row, col) = wAdjacency(col, row) = bonds[i]->getOrder();
+        }
+
+        // make the degree matrix
+        degree.zeros(atoms.size(), atoms.size());
+        for (int i = 0; i < atoms.size(); ++i) {
+            int sum = 0;
+            for (int j = 0; j < atoms.size(); ++j) {
+                sum += wAdjacency(i, j);
+            }
+            degree(i, i) = sum;
         }
-        degree(i, i) = sum;
+
+        // make the laplacian matrix
+        laplacian = degree - wAdjacency;
     }
 
-    // make the laplacian matrix
-    laplacian = degree - wAdjacency;
+    // calculate the fiedler vector (the eigenvector of the second smallest eigenvalue),
+    // unless the spectrum of an isomorphic graph is already cached
+    // (the graph's colours also order the atoms when the Fiedler vector is ambiguous)
+    if (hash == nullptr) {
+        graph.compute(mol);
+        hash = &graph;
+    }
+    bool cached = false;
+    if (cache != nullptr) {
+        TraceSpan span("cache_lookup");
+        cached = cache->lookup(*hash, cachedBasis, cachedEigenvalues);
+        span.setArg("hit", cached);
+    }
+    int n = atoms.size(), first, last;
+    if (cached) { // the Fiedler vector is chosen again, at this numbering's atoms
+        for (double value : cachedEigenvalues) eigenvalues.add(value);
+        findFiedlerEigenspace(cachedEigenvalues.data(), n, first, last);
+        canonicalFiedler(cachedBasis.data(), n, last - first + 1, first == 0, hash->getColors(),
+                         anchorOrder, projection);
+        for (double value : projection) fiedler.add(value);
+    } else if (n > 1) {
+        {
+            TraceSpan span("eig_sym");
+            span.setArg("atoms", atoms.size());
+            span.setArg("bonds", bonds.size());
+            arma::eig_sym(eigenvalueWork, eigenvectorWork, laplacian);
+        }
+        findFiedlerEigenspace(eigenvalueWork.memptr(), n, first, last);
+        canonicalFiedler(eigenvectorWork.colptr(first), n, last - first + 1, first == 0, hash->getColors(),
+                         anchorOrder, projection);
+        for (double value : projection) fiedler.add(value);
+        for (int i = 0; i < n; ++i) {
+            eigenvalues.add(eigenvalueWork(i));
+        }
+        if (cache != nullptr) cache->insert(*hash, eigenvectorWork.colptr(first), last - first + 1, eigenvalueWork.memptr());
+    } else {
+        for (int i = 0; i < atoms.size(); ++i) {
+            fiedler.add(0);
+            eigenvalues.add(0);
+        }
+    }
+}
 
-    // calculate the fiedler vector
-    arma::Col<double> eigenvalues;
-    arma::Mat<double> eigenvectors;
-    arma::eig_sym(eigenvalues, eigenvectors, laplacian);
-    for (int i = 0; i < atoms.size(); ++i) {
-        fiedler.add(eigenvectors(1, i));
+Vector<int> MolGraph::getClusters() {
+    std::vector<int> clusters;
+    getClusters(clusters);
+    Vector<int> result;
+    for (int cluster : clusters) result.add(cluster);
+    return result;
+}
+
+void MolGraph::getClusters(std::vector<int>& clusters) {
+    TraceSpan span("cluster");
+    span.setArg("atoms", ringSystem.size());
+    if (backend == MultilevelBackend) {
+        clusters.assign(partition.begin(), partition.end());
+        return;
     }
+    systemSum.assign(numRingSystems, 0.0);
+    double largest = 0;
+    for (int i = 0; i < fiedler.size(); ++i) {
+        if (ringSystem[i] != -1) systemSum[ringSystem[i]] += fiedler[i];
+        largest = std::max(largest, std::abs(fiedler[i]));
+    }
+    // values that are zero but for rounding (atoms on a mirror plane) always go second
+    double zero = 1e-9 * largest;
+    clusters.resize(fiedler.size());
+    for (int i = 0; i < fiedler.size(); ++i) {
+        double value = ringSystem[i] == -1 ? fiedler[i] : systemSum[ringSystem[i]];
+        clusters[i] = value > zero ? 0 : 1;
+    }
+}
+
+Vector<double> MolGraph::getFiedlerVector() {
+    return fiedler;
+}
+
+Vector<double> MolGraph::getEigenvalues() {
+    return eigenvalues;
+}
+
+const RingPerception& MolGraph::getRings() const {
+    return rings;
 }
 
 void MolGraph::retrosynthesize() {
+    Vector<int> clusters = getClusters();
     Vector<int> one, two;
-    for (int i = 0; i < fiedler.size(); ++i) {
-        if (fiedler[i] > 0) {
+    for (int i = 0; i < clusters.size(); ++i) {
+        if (clusters[i] == 0) {
             one.add(i);
         } else {
             two.add(i);
@@ -10,8 +10,25 @@
  * Linear algebra calculations done via Armadillo package.
  */
 
+#ifndef _molgraph_h
+#define _molgraph_h
+
+#include <vector>
 #include <armadillo>
 #include "molecule.h"
+#include "multilevel.h"
+#include "rings.h"
+#include "spectrumcache.h"
+
+/**
+ * Enum: PartitionBackend
+ * ----------------------
+ * The algorithms a MolGraph can use to split a molecule into two clusters.
+ */
+enum PartitionBackend {
+    SpectralBackend,   // sign of the Fiedler vector of the dense Laplacian
+    MultilevelBackend  // multilevel coarsening partitioner, linear in the number of atoms
+};
 
 class MolGraph {
 public:
@@ -32,6 +49,39 @@ public:
      */
     MolGraph(Molecule& mol);
 
+    /**
+     * Function: MolGraph
+     * Parameters: mol, cache
+     * Usage: Molgraph molgraph(mol, &cache);
+     * --------------------------------------
+     * Initializes a new MolGraph object based on the molecule given, reusing
+     * the spectrum of any isomorphic graph already in the cache (and adding
+     * this one's otherwise).
+     */
+    MolGraph(Molecule& mol, SpectrumCache* cache);
+
+    /**
+     * Function: MolGraph
+     * Parameters: mol, backend, cache
+     * Usage: Molgraph molgraph(mol, MultilevelBackend);
+     * -------------------------------------------------
+     * Initializes a new MolGraph object that splits the molecule with the
+     * given backend. The multilevel backend does not build the dense matrices,
+     * so printGraphs has nothing to show and the Fiedler vector is empty.
+     */
+    MolGraph(Molecule& mol, PartitionBackend backend, SpectrumCache* cache = nullptr);
+
+    /**
+     * Function: MolGraph
+     * Parameters: backend, cache
+     * Usage: Molgraph molgraph(SpectralBackend, &cache);
+     * --------------------------------------------------
+     * Initializes an empty MolGraph object that will split molecules with the
+     * given backend. A worker that converts one molecule after another into
+     * the same MolGraph reuses its matrices instead of reallocating them.
+     */
+    MolGraph(PartitionBackend backend, SpectrumCache* cache = nullptr);
+
     /**
      * Destructor: ~MolGraph
      * Usage: delete molgraph
@@ -45,10 +95,22 @@ public:
      * Parameters: mol
      * Usage: molgraph.moleculeToGraph(mol);
      * --------------------------------
-     * Converts the properties of the molecule into the current MolGraph object.
+     * Converts the properties of the molecule into the current MolGraph object,
+     * replacing whatever it held before. Matrix storage is reused when the
+     * new molecule is no larger than the previous one.
      */
     void moleculeToGraph(Molecule& mol);
 
+    /**
+     * Function: moleculeToGraph
+     * Parameters: mol, hash
+     * Usage: molgraph.moleculeToGraph(mol, hash);
+     * -------------------------------------------
+     * Converts the molecule as above, using a GraphHash already computed for
+     * it, in the same atom order, instead of hashing it again.
+     */
+    void moleculeToGraph(Molecule& mol, const GraphHash& hash);
+
     /**
      * Function: retrosynthesize
      * Usage: molgraph.retrosynthesize()
@@ -57,6 +119,57 @@ public:
      */
     void retrosynthesize();
 
+    /**
+     * Function: getClusters
+     * Usage: Vector<int> clusters = molgraph.getClusters();
+     * -----------------------------------------------------
+     * Returns the cluster (0 or 1) of each atom. With the spectral backend,
+     * atoms are split by the sign of the Fiedler vector, except that every
+     * ring system is kept whole: ring bonds are never cut, so a ring system
+     * goes to the side where the sum of its Fiedler entries lies. Entries
+     * that are zero but for rounding go to cluster 1. The multilevel backend
+     * keeps ring systems whole as well.
+     */
+    Vector<int> getClusters();
+
+    /**
+     * Function: getClusters
+     * Parameters: clusters
+     * Usage: molgraph.getClusters(clusters);
+     * --------------------------------------
+     * As above, filling in the caller's vector, which keeps its capacity from
+     * one molecule to the next.
+     */
+    void getClusters(std::vector<int>& clusters);
+
+    /**
+     * Function: getFiedlerVector
+     * Usage: Vector<double> fiedler = molgraph.getFiedlerVector();
+     * ------------------------------------------------------------
+     * Returns the Fiedler vector, one entry per atom. Its sign, and the
+     * choice within the eigenspace when the second smallest eigenvalue is
+     * repeated, are fixed by the graph rather than by the eigensolver, so
+     * the same molecule always gets the same vector.
+     */
+    Vector<double> getFiedlerVector();
+
+    /**
+     * Function: getEigenvalues
+     * Usage: Vector<double> eigenvalues = molgraph.getEigenvalues();
+     * --------------------------------------------------------------
+     * Returns the eigenvalues of the Laplacian matrix in ascending order.
+     */
+    Vector<double> getEigenvalues();
+
+    /**
+     * Function: getRings
+     * Usage: const RingPerception& rings = molgraph.getRings();
+     * ---------------------------------------------------------
+     * Returns the rings found in the molecule last converted, so that
+     * callers need not perceive them again. Valid until the next conversion.
+     */
+    const RingPerception& getRings() const;
+
     /**
      * Function: printGraphs
      * Usage: molgraph.printGraphs();
@@ -69,7 +182,33 @@ private:
     // stores the matrices needed for spectral clustering
     arma::Mat<double> degree, wAdjacency, laplacian;
 
+    // workspaces reused from one molecule to the next
+    arma::Col<double> eigenvalueWork;
+    arma::Mat<double> eigenvectorWork;
+    RingPerception rings;
+    MultilevelPartitioner partitioner;
+    GraphHash graph;
+    std::vector<double> cachedBasis, cachedEigenvalues;
+    std::vector<int> anchorOrder;      // atoms in the order canonicalFiedler tries them
+    std::vector<double> projection, systemSum;
+
     // the Fiedler eigenvector: used to assign clusters
     Vector<double> fiedler;
+    Vector<double> eigenvalues;
+
+    // spectra of previously seen graphs (not owned)
+    SpectrumCache* cache = nullptr;
+
+    // how the molecule is split, and the split itself for the multilevel backend
+    PartitionBackend backend = SpectralBackend;
+    Vector<int> partition;
+
+    // ring system of each atom (-1 if acyclic); ring bonds are uncuttable
+    Vector<int> ringSystem;
+    int numRingSystems = 0;
+
+    void convert(Molecule& mol, const GraphHash* hash);
 
 };
+
+#endif
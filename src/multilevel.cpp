@@ -0,0 +1,359 @@
+/**
+ * File: multilevel.cpp
+ * --------------------
+ * This file contains the implementation for the MultilevelPartitioner interface.
+ * Documentation for each method can be found in the multilevel.h file.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <armadillo>
+#include "fiedler.h"
+#include "multilevel.h"
+
+// coarsening stops once the graph is this small
+static const int COARSEST_SIZE = 32;
+
+// coarsening also stops if a round shrinks the graph by less than this fraction
+static const double MIN_COARSENING = 0.05;
+
+// coarsest graphs up to this size are split with a dense eigendecomposition
+static const int MAX_SPECTRAL_SIZE = 512;
+
+// the coarsest Fiedler vector is chosen by vertex index alone
+static const std::vector<uint64_t> NO_COLORS;
+
+// refinement limits per level
+static const int MAX_REFINEMENT_PASSES = 8;
+static const int MAX_UNPRODUCTIVE_MOVES = 64;
+
+// helper function declarations
+static void breadthFirstOrder(int n, const std::vector<int>& start, const std::vector<int>& adj,
+                              std::vector<double>& guide, std::vector<int>& dist, std::vector<int>& queue);
+
+MultilevelPartitioner::MultilevelPartitioner() : numLevels(0) {}
+
+void MultilevelPartitioner::partition(const Molecule& mol, const RingPerception& rings, Vector<int>& clusters) {
+    ArrayView<Atom*> atoms = mol.getAtoms();
+    ArrayView<Bond*> bonds = mol.getBonds();
+    int n = atoms.size();
+    clusters.clear();
+    if (n == 0) return;
+
+    // the atom graph, with bond orders as edge weights
+    atomLevel.n = n;
+    atomLevel.start.assign(n + 1, 0);
+    atomLevel.vertexWeight.assign(n, 1);
+    for (int i = 0; i < bonds.size(); ++i) {
+        int a = bonds[i]->getFirstAtom()->getIndex(), b = bonds[i]->getSecondAtom()->getIndex();
+        if (a == b) continue;
+        atomLevel.start[a + 1]++;
+        atomLevel.start[b + 1]++;
+    }
+    for (int a = 0; a < n; ++a) atomLevel.start[a + 1] += atomLevel.start[a];
+    atomLevel.adj.resize(atomLevel.start[n]);
+    atomLevel.edgeWeight.resize(atomLevel.start[n]);
+    fill.assign(atomLevel.start.begin(), atomLevel.start.end() - 1);
+    for (int i = 0; i < bonds.size(); ++i) {
+        int a = bonds[i]->getFirstAtom()->getIndex(), b = bonds[i]->getSecondAtom()->getIndex();
+        if (a == b) continue;
+        atomLevel.adj[fill[a]] = b;
+        atomLevel.edgeWeight[fill[a]++] = bonds[i]->getOrder();
+        atomLevel.adj[fill[b]] = a;
+        atomLevel.edgeWeight[fill[b]++] = bonds[i]->getOrder();
+    }
+
+    // level 0 has one vertex per ring system and per acyclic atom
+    atomVertex.resize(n);
+    int nvertices = rings.getNumRingSystems();
+    for (int a = 0; a < n; ++a) {
+        int system = rings.getRingSystem(a);
+        atomVertex[a] = system != -1 ? system : nvertices++;
+    }
+    if (levels.empty()) levels.emplace_back();
+    numLevels = 1;
+    contract(atomLevel, atomVertex, nvertices, levels[0]);
+
+    // coarsen; levels left over from earlier molecules are overwritten, keeping their storage
+    double maxVertexWeight = 1.5 * n / COARSEST_SIZE;
+    while (levels[numLevels - 1].n > COARSEST_SIZE) {
+        int ncoarse = match(levels[numLevels - 1], map, maxVertexWeight);
+        if (ncoarse > (1 - MIN_COARSENING) * levels[numLevels - 1].n) break; // coarsening has stalled
+        levels[numLevels - 1].coarse = map;
+        if (numLevels == (int) levels.size()) levels.emplace_back();
+        numLevels++;
+        contract(levels[numLevels - 2], map, ncoarse, levels[numLevels - 1]);
+    }
+
+    // split the coarsest graph, then project and refine back to level 0
+    double threshold;
+    initialPartition(levels[numLevels - 1], part, guide, threshold);
+    for (int l = numLevels - 1; l >= 0; --l) {
+        if (l < numLevels - 1) {
+            finePart.resize(levels[l].n);
+            fineGuide.resize(levels[l].n);
+            for (int v = 0; v < levels[l].n; ++v) {
+                finePart[v] = part[levels[l].coarse[v]];
+                fineGuide[v] = guide[levels[l].coarse[v]];
+            }
+            part.swap(finePart);
+            guide.swap(fineGuide);
+        }
+        refine(levels[l], part, guide, threshold);
+    }
+
+    for (int a = 0; a < n; ++a) clusters.add(part[atomVertex[a]]);
+}
+
+/*
+ * Builds the coarse graph in which fine vertex v becomes vertex map[v].
+ * Parallel edges are merged by adding their weights and edges inside a
+ * coarse vertex disappear. Linear in the size of the fine graph.
+ */
+void MultilevelPartitioner::contract(const Level& fine, const std::vector<int>& map, int ncoarse,
+                                     Level& coarse) {
+    coarse.n = ncoarse;
+    coarse.vertexWeight.assign(ncoarse, 0);
+    memberStart.assign(ncoarse + 1, 0);
+    members.resize(fine.n);
+    for (int v = 0; v < fine.n; ++v) {
+        coarse.vertexWeight[map[v]] += fine.vertexWeight[v];
+        memberStart[map[v] + 1]++;
+    }
+    for (int c = 0; c < ncoarse; ++c) memberStart[c + 1] += memberStart[c];
+    fill.assign(memberStart.begin(), memberStart.end() - 1);
+    for (int v = 0; v < fine.n; ++v) members[fill[map[v]]++] = v;
+
+    coarse.start.assign(ncoarse + 1, 0);
+    coarse.adj.clear();
+    coarse.edgeWeight.clear();
+    slot.assign(ncoarse, -1); // where each neighbour's edge sits in the current row
+    for (int c = 0; c < ncoarse; ++c) {
+        coarse.start[c] = coarse.adj.size();
+        for (int i = memberStart[c]; i < memberStart[c + 1]; ++i) {
+            int v = members[i];
+            for (int k = fine.start[v]; k < fine.start[v + 1]; ++k) {
+                int u = map[fine.adj[k]];
+                if (u == c) continue;
+                if (slot[u] == -1) {
+                    slot[u] = coarse.adj.size();
+                    coarse.adj.push_back(u);
+                    coarse.edgeWeight.push_back(0);
+                }
+                coarse.edgeWeight[slot[u]] += fine.edgeWeight[k];
+            }
+        }
+        for (size_t k = coarse.start[c]; k < coarse.adj.size(); ++k) slot[coarse.adj[k]] = -1;
+    }
+    coarse.start[ncoarse] = coarse.adj.size();
+}
+
+/*
+ * Heavy-edge matching: each unmatched vertex, lowest degree first, is paired
+ * with the unmatched neighbour it shares the heaviest bond with, as long as
+ * the merged vertex stays below maxVertexWeight. Returns the number of
+ * coarse vertices and fills map with each vertex's coarse vertex.
+ */
+int MultilevelPartitioner::match(const Level& level, std::vector<int>& map, double maxVertexWeight) {
+    int n = level.n;
+    byDegree.resize(n);
+    degreeStart.assign(n + 1, 0);
+    for (int v = 0; v < n; ++v) degreeStart[level.start[v + 1] - level.start[v]]++;
+    for (int d = 0, sum = 0; d <= n; ++d) {
+        int count = degreeStart[d];
+        degreeStart[d] = sum;
+        sum += count;
+    }
+    for (int v = 0; v < n; ++v) byDegree[degreeStart[level.start[v + 1] - level.start[v]]++] = v;
+
+    map.assign(n, -1);
+    int ncoarse = 0;
+    for (int v : byDegree) {
+        if (map[v] != -1) continue;
+        int best = -1;
+        for (int k = level.start[v]; k < level.start[v + 1]; ++k) {
+            int u = level.adj[k];
+            if (map[u] != -1 || level.vertexWeight[v] + level.vertexWeight[u] > maxVertexWeight) continue;
+            if (best == -1 || level.edgeWeight[k] > level.edgeWeight[best] ||
+                    (level.edgeWeight[k] == level.edgeWeight[best] &&
+                     level.vertexWeight[u] < level.vertexWeight[level.adj[best]])) {
+                best = k;
+            }
+        }
+        map[v] = ncoarse;
+        if (best != -1) map[level.adj[best]] = ncoarse;
+        ncoarse++;
+    }
+    return ncoarse;
+}
+
+/*
+ * Orders the coarsest vertices along the Fiedler vector of the weighted
+ * Laplacian (or, if coarsening stalled on a large graph, by breadth-first
+ * distance) and takes the prefix with the lowest ratio cut,
+ * cut / (weight of one side * weight of the other). The Fiedler vector is
+ * chosen as in MolGraph, so its sign does not depend on the LAPACK build.
+ */
+void MultilevelPartitioner::initialPartition(const Level& level, std::vector<int>& part,
+                                             std::vector<double>& guide, double& threshold) {
+    int n = level.n;
+    part.assign(n, 0);
+    guide.assign(n, 0);
+    threshold = 0;
+    if (n < 2) return;
+
+    if (n <= MAX_SPECTRAL_SIZE) {
+        laplacian.zeros(n, n);
+        for (int v = 0; v < n; ++v) {
+            for (int k = level.start[v]; k < level.start[v + 1]; ++k) {
+                laplacian(v, level.adj[k]) -= level.edgeWeight[k];
+                laplacian(v, v) += level.edgeWeight[k];
+            }
+        }
+        arma::eig_sym(eigenvalues, eigenvectors, laplacian);
+        int first, last; // coarse vertices have no colours of their own, so they are tried by index
+        findFiedlerEigenspace(eigenvalues.memptr(), n, first, last);
+        canonicalFiedler(eigenvectors.colptr(first), n, last - first + 1, first == 0, NO_COLORS,
+                         vertexOrder, guide);
+    } else {
+        breadthFirstOrder(n, level.start, level.adj, guide, dist, queue);
+    }
+
+    order.resize(n);
+    for (int v = 0; v < n; ++v) order[v] = v;
+    std::sort(order.begin(), order.end(), [&](int x, int y) { // ties by index, as a stable sort would
+        return guide[x] < guide[y] || (guide[x] == guide[y] && x < y);
+    });
+
+    double total = 0;
+    for (double weight : level.vertexWeight) total += weight;
+    inPrefix.assign(n, false);
+    double cut = 0, prefixWeight = 0, bestRatio = 0;
+    int best = -1;
+    for (int i = 0; i < n - 1; ++i) {
+        int v = order[i];
+        inPrefix[v] = true;
+        prefixWeight += level.vertexWeight[v];
+        for (int k = level.start[v]; k < level.start[v + 1]; ++k) {
+            cut += inPrefix[level.adj[k]] ? -level.edgeWeight[k] : level.edgeWeight[k];
+        }
+        double ratio = cut / (prefixWeight * (total - prefixWeight));
+        if (best == -1 || ratio < bestRatio) {
+            best = i;
+            bestRatio = ratio;
+        }
+    }
+    threshold = (guide[order[best]] + guide[order[best + 1]]) / 2;
+    for (int i = 0; i < n; ++i) part[order[i]] = i <= best ? 1 : 0; // low Fiedler values form cluster 1
+}
+
+/*
+ * Fiduccia-Mattheyses refinement. Each pass moves boundary vertices one at a
+ * time, highest gain (reduction in cut weight) first, locking each moved
+ * vertex, and then rolls back to the best point seen. Neither side may drop
+ * below half the weight of the lighter side at the start of the pass.
+ */
+void MultilevelPartitioner::refine(const Level& level, std::vector<int>& part,
+                                   const std::vector<double>& guide, double threshold) {
+    int n = level.n;
+    if (n < 2) return;
+    gain.resize(n);
+    version.resize(n);
+    locked.resize(n);
+    for (int pass = 0; pass < MAX_REFINEMENT_PASSES; ++pass) {
+        double sideWeight[2] = {0, 0};
+        heap.clear(); // a binary max-heap, kept with std::push_heap and std::pop_heap
+        for (int v = 0; v < n; ++v) {
+            sideWeight[part[v]] += level.vertexWeight[v];
+            gain[v] = 0;
+            bool boundary = false;
+            for (int k = level.start[v]; k < level.start[v + 1]; ++k) {
+                bool external = part[level.adj[k]] != part[v];
+                gain[v] += external ? level.edgeWeight[k] : -level.edgeWeight[k];
+                boundary = boundary || external;
+            }
+            version[v] = 0;
+            locked[v] = false;
+            if (boundary) {
+                heap.push_back({gain[v], -std::fabs(guide[v] - threshold), v, 0});
+                std::push_heap(heap.begin(), heap.end());
+            }
+        }
+        double floor = std::min(sideWeight[0], sideWeight[1]) / 2;
+
+        moves.clear();
+        double cumulative = 0, best = 0;
+        size_t bestMoves = 0;
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end());
+            Candidate top = heap.back();
+            heap.pop_back();
+            int v = top.vertex;
+            if (locked[v] || top.version != version[v]) continue;
+            double remaining = sideWeight[part[v]] - level.vertexWeight[v];
+            if (remaining <= 0 || remaining < floor) continue;
+
+            sideWeight[part[v]] -= level.vertexWeight[v];
+            part[v] = 1 - part[v];
+            sideWeight[part[v]] += level.vertexWeight[v];
+            locked[v] = true;
+            cumulative += gain[v];
+            gain[v] = -gain[v];
+            moves.push_back(v);
+            for (int k = level.start[v]; k < level.start[v + 1]; ++k) {
+                int u = level.adj[k];
+                gain[u] += part[u] == part[v] ? -2 * level.edgeWeight[k] : 2 * level.edgeWeight[k];
+                if (!locked[u]) {
+                    heap.push_back({gain[u], -std::fabs(guide[u] - threshold), u, ++version[u]});
+                    std::push_heap(heap.begin(), heap.end());
+                }
+            }
+            if (cumulative > best + 1e-9) {
+                best = cumulative;
+                bestMoves = moves.size();
+            } else if (moves.size() - bestMoves > MAX_UNPRODUCTIVE_MOVES) {
+                break;
+            }
+        }
+        for (size_t i = moves.size(); i > bestMoves; --i) part[moves[i - 1]] ^= 1; // roll back
+        if (bestMoves == 0) break;
+    }
+}
+
+/*
+ * Fallback ordering for large coarsest graphs: breadth-first distance from a
+ * pseudo-peripheral vertex (the far end of a search from vertex 0), one
+ * connected component after another.
+ */
+static void breadthFirstOrder(int n, const std::vector<int>& start, const std::vector<int>& adj,
+                              std::vector<double>& guide, std::vector<int>& dist, std::vector<int>& queue) {
+    dist.assign(n, -1);
+    auto search = [&](int root) {
+        queue.clear();
+        queue.push_back(root);
+        dist[root] = 0;
+        for (size_t head = 0; head < queue.size(); ++head) {
+            int v = queue[head];
+            for (int k = start[v]; k < start[v + 1]; ++k) {
+                if (dist[adj[k]] == -1) {
+                    dist[adj[k]] = dist[v] + 1;
+                    queue.push_back(adj[k]);
+                }
+            }
+        }
+        return queue.back();
+    };
+    double offset = 0;
+    for (int root = 0; root < n; ++root) {
+        if (dist[root] != -1) continue;
+        int far = search(root);
+        for (int v : queue) dist[v] = -1;
+        search(far);
+        int depth = 0;
+        for (int v : queue) {
+            guide[v] = offset + dist[v];
+            depth = std::max(depth, dist[v]);
+        }
+        offset += depth + 1;
+    }
+}
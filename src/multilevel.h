@@ -0,0 +1,97 @@
+/**
+ * File: multilevel.h
+ * ------------------
+ * This file contains the interface for the MultilevelPartitioner class.
+ * The MultilevelPartitioner splits a Molecule into two clusters in
+ * roughly linear time, for molecules too large for a dense
+ * eigendecomposition (polymers, peptides, biologics).
+ *
+ * It works in the style of METIS:
+ * 1. every ring system is contracted to a single vertex, so ring bonds
+ *    can never be cut;
+ * 2. the graph is coarsened by repeatedly contracting a heavy-edge
+ *    matching, with bond orders as edge weights;
+ * 3. the small coarsest graph is split by a sweep along its Fiedler
+ *    vector, choosing the split with the best ratio cut;
+ * 4. the split is projected back level by level, and refined at each
+ *    level with Fiduccia-Mattheyses moves, ties broken in favour of
+ *    vertices whose Fiedler value lies nearest the split.
+ */
+
+#ifndef _multilevel_h
+#define _multilevel_h
+
+#include <vector>
+#include <armadillo>
+#include "vector.h"
+#include "molecule.h"
+#include "rings.h"
+
+class MultilevelPartitioner {
+public:
+    /**
+     * Constructor: MultilevelPartitioner
+     * Usage: MultilevelPartitioner partitioner;
+     * -----------------------------------------
+     * Initializes a new MultilevelPartitioner object.
+     */
+    MultilevelPartitioner();
+
+    /**
+     * Function: partition
+     * Parameters: mol, rings, clusters
+     * Usage: partitioner.partition(mol, rings, clusters);
+     * ---------------------------------------------------
+     * Fills clusters with the cluster (0 or 1) of each atom of the molecule.
+     * rings must have been perceived on the same molecule; no ring bond is
+     * ever cut. A partitioner kept from one molecule to the next reuses its
+     * levels and scratch space.
+     */
+    void partition(const Molecule& mol, const RingPerception& rings, Vector<int>& clusters);
+
+private:
+    // one level of the coarsening hierarchy, in compressed adjacency form
+    struct Level {
+        int n;
+        std::vector<int> start, adj;
+        std::vector<double> edgeWeight, vertexWeight;
+        std::vector<int> coarse; // the vertex each vertex is merged into on the next level
+    };
+
+    // a vertex waiting to be moved during refinement
+    struct Candidate {
+        double gain, closeness;
+        int vertex, version;
+        bool operator<(const Candidate& other) const {
+            if (gain != other.gain) return gain < other.gain;
+            return closeness < other.closeness;
+        }
+    };
+
+    std::vector<Level> levels; // only the first numLevels are in use
+    int numLevels;
+
+    // workspaces reused from one molecule to the next
+    Level atomLevel;
+    std::vector<int> atomVertex, fill, map, part, finePart;
+    std::vector<double> guide, fineGuide;
+    std::vector<int> memberStart, members, slot;          // contract
+    std::vector<int> byDegree, degreeStart;               // match
+    arma::Mat<double> laplacian, eigenvectors;            // initialPartition
+    arma::Col<double> eigenvalues;
+    std::vector<int> vertexOrder, order, dist, queue;
+    std::vector<bool> inPrefix;
+    std::vector<double> gain;                             // refine
+    std::vector<int> version, moves;
+    std::vector<bool> locked;
+    std::vector<Candidate> heap;
+
+    void contract(const Level& fine, const std::vector<int>& map, int ncoarse, Level& coarse);
+    int match(const Level& level, std::vector<int>& map, double maxVertexWeight);
+    void initialPartition(const Level& level, std::vector<int>& part, std::vector<double>& guide,
+                          double& threshold);
+    void refine(const Level& level, std::vector<int>& part, const std::vector<double>& guide,
+                double threshold);
+};
+
+#endif
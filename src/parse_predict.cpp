@@ -20,6 +20,8 @@
 #include "queue.h"
 
 #include "molgraph.h"
+#include "retrosearch.h"
+#include "batch.h"
 using namespace std;
 
 /**
@@ -51,15 +53,31 @@ void giveExamples() {
     cout << "Decalin: \t\t C1CC2CCCCC2CC1" << endl << endl;
 }
 
+/**
+ * Function: readMolecule
+ * ----------------------
+ * Asks for a SMILES string and parses it into mol. If the string is not
+ * valid SMILES, shows where and why and returns false.
+ */
+bool readMolecule(Molecule& mol) {
+    string smiles;
+    getLine("Enter a SMILES string: ", smiles);
+    SmilesError problem;
+    if (mol.parseSmiles(smiles.data(), smiles.size(), problem)) return true;
+    cerr << "Invalid SMILES at position " << problem.offset << ": " << problem.reason << endl;
+    cerr << "  " << smiles << endl;
+    cerr << "  " << string(problem.offset, ' ') << "^" << endl << endl;
+    return false;
+}
+
 /**
  * Function: smilesToMolecule
  * --------------------------
  * Converts a SMILES to MDL MolFile and prints it.
  */
 void smilesToMolecule() {
-    string smiles;
-    getLine("Enter a SMILES string: ", smiles);
-    Molecule mol(smiles);
+    Molecule mol;
+    if (!readMolecule(mol)) return;
     mol.printMolecule();
     cout << endl;
 }
@@ -70,9 +88,8 @@ void smilesToMolecule() {
  * Prints the graph versions of the SMILES string.
  */
 void smilesToGraph() {
-    string smiles;
-    getLine("Enter a SMILES string: ", smiles);
-    Molecule mol(smiles);
+    Molecule mol;
+    if (!readMolecule(mol)) return;
     MolGraph graph(mol);
     graph.printGraphs();
 }
@@ -83,14 +100,42 @@ void smilesToGraph() {
  * Returns the two clusters each atom falls into.
  */
 void retrosynthesize() {
-    string smiles;
-    getLine("Enter a SMILES string: ", smiles);
-    Molecule mol(smiles);
+    Molecule mol;
+    if (!readMolecule(mol)) return;
     MolGraph graph(mol);
     graph.retrosynthesize();
     cout << endl;
 }
 
+/**
+ * Function: retrosynthesizeLarge
+ * ------------------------------
+ * Returns the two clusters each atom falls into, using the multilevel
+ * partitioner, which scales to very large molecules.
+ */
+void retrosynthesizeLarge() {
+    Molecule mol;
+    if (!readMolecule(mol)) return;
+    MolGraph graph(mol, MultilevelBackend);
+    graph.retrosynthesize();
+    cout << endl;
+}
+
+/**
+ * Function: retrosynthesizeRoutes
+ * -------------------------------
+ * Searches several retrosynthetic steps deep and prints the route tree.
+ */
+void retrosynthesizeRoutes() {
+    Molecule mol;
+    if (!readMolecule(mol)) return;
+    SearchOptions options;
+    options.maxDepth = getInteger("Number of steps: ");
+    RetroSearch search(options);
+    search.printRoutes(mol, search.search(mol));
+    cout << endl;
+}
+
 /**
  * Function: welcome
  * -----------------
@@ -116,6 +161,8 @@ enum ChemOption {
     SmilesToMolecule,
     SmilesToGraph,
     Retrosynthesis,
+    LargeRetrosynthesis,
+    RouteSearch,
     Quit,
     NumOptions
 };
@@ -128,6 +175,8 @@ void displayOptions() {
     cout << "  " << SmilesToMolecule    << "\t Convert SMILES to MDL MolFile Format." << endl;
     cout << "  " << SmilesToGraph       << "\t Convert SMILES to a molecular graph." << endl;
     cout << "  " << Retrosynthesis      << "\t Predict a single retrosynthetic step." << endl;
+    cout << "  " << LargeRetrosynthesis << "\t Predict a single retrosynthetic step for a very large molecule." << endl;
+    cout << "  " << RouteSearch         << "\t Search several retrosynthetic steps deep." << endl;
     cout << "  " << Quit                << "\t Quit." << endl;
 }
 
@@ -148,6 +197,12 @@ bool processInput(ChemOption option) {
     case Retrosynthesis:
         retrosynthesize();
         break;
+    case LargeRetrosynthesis:
+        retrosynthesizeLarge();
+        break;
+    case RouteSearch:
+        retrosynthesizeRoutes();
+        break;
     case Quit:
         return false;
     default:
@@ -166,7 +221,15 @@ ChemOption getUserInput() {
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
+    if (argc > 1) { // batch mode
+        BatchOptions options;
+        if (!parseBatchOptions(argc, argv, options)) {
+            printBatchUsage();
+            return 1;
+        }
+        return runBatch(options);
+    }
     welcome();
     do {
         displayOptions();
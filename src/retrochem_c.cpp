@@ -0,0 +1,166 @@
+/**
+ * File: retrochem_c.cpp
+ * ---------------------
+ * This file contains the implementation for RetroCHEM's C interface.
+ * Documentation for each function can be found in the retrochem_c.h file.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "retrochem_c.h"
+#include "arena.h"
+#include "molecule.h"
+#include "molgraph.h"
+#include "scheduler.h"
+#include "smilesindex.h"
+#include "spectrumcache.h"
+
+// most molecules handed to the scheduler in one round
+static const size_t MAX_ROUND = 1 << 20;
+
+/*
+ * The state one worker thread reuses from one molecule to the next.
+ */
+struct PoolWorker {
+    MolArena arena;
+    Molecule mol;
+    MolGraph graph;
+    std::vector<int> clusters;
+
+    PoolWorker(PartitionBackend backend, SpectrumCache& cache) : mol(&arena), graph(backend, &cache) {}
+};
+
+struct retrochem_pool {
+    BatchScheduler scheduler;
+    SpectrumCache cache;
+    PartitionBackend backend;
+    std::vector<std::unique_ptr<PoolWorker>> workers;
+    SmilesIndex sizing; // rebuilt for each molecule when choosing its lane
+    std::mutex lock; // one batch at a time
+
+    // the BLAS thread settings belong to the host process, so the scheduler leaves them
+    // alone and runs every molecule, large or not, on the pool
+    retrochem_pool(int threads, PartitionBackend partitioner) :
+        scheduler(threads, INT_MAX, false), backend(partitioner) {
+        for (int i = 0; i < scheduler.getNumContexts(); ++i) {
+            workers.emplace_back(new PoolWorker(backend, cache));
+        }
+    }
+};
+
+/*
+ * Where one batch reads its molecules and writes its results.
+ */
+struct PoolBatch {
+    const char* const* smiles;
+    const size_t* lengths;
+    size_t stride;
+    int32_t* clusters;
+    double* fiedler;
+    int32_t* atoms;
+    int32_t* bonds;
+    int32_t* status;
+};
+
+// helper function declarations
+static int estimateAtoms(const PoolBatch& batch, size_t i, SmilesIndex& index);
+static int32_t splitMolecule(const PoolBatch& batch, size_t i, PoolWorker& worker);
+
+int retrochem_api_version(void) {
+    return RETROCHEM_C_API_VERSION;
+}
+
+retrochem_pool* retrochem_pool_create(int threads, int backend) {
+    if (threads < 0) return nullptr;
+    if (backend != RETROCHEM_SPECTRAL && backend != RETROCHEM_MULTILEVEL) return nullptr;
+    try {
+        return new retrochem_pool(threads, backend == RETROCHEM_SPECTRAL ? SpectralBackend : MultilevelBackend);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void retrochem_pool_destroy(retrochem_pool* pool) {
+    delete pool;
+}
+
+int retrochem_pool_threads(const retrochem_pool* pool) {
+    return pool == nullptr ? 0 : pool->scheduler.getNumWorkers();
+}
+
+int retrochem_split_batch(retrochem_pool* pool, size_t count,
+                          const char* const* smiles, const size_t* lengths, size_t stride,
+                          int32_t* clusters, double* fiedler,
+                          int32_t* atoms, int32_t* bonds, int32_t* status) {
+    if (count == 0) return RETROCHEM_OK;
+    if (pool == nullptr || smiles == nullptr || lengths == nullptr) return RETROCHEM_INVALID_ARGUMENT;
+    PoolBatch batch = {smiles, lengths, stride, clusters, fiedler, atoms, bonds, status};
+    try {
+        std::lock_guard<std::mutex> guard(pool->lock);
+        for (size_t first = 0; first < count; first += MAX_ROUND) {
+            int round = std::min(count - first, MAX_ROUND);
+            pool->scheduler.run(round, [&](int job) { return estimateAtoms(batch, first + job, pool->sizing); },
+                                [&](int job, int worker) {
+                size_t i = first + job;
+                int32_t result = splitMolecule(batch, i, *pool->workers[worker]);
+                if (status != nullptr) status[i] = result;
+            });
+        }
+    } catch (...) {
+        // splitMolecule lets nothing escape, so only the pool itself can get here
+        return RETROCHEM_INTERNAL_ERROR;
+    }
+    return RETROCHEM_OK;
+}
+
+/*
+ * Counts the atoms of molecule i without parsing it, to choose its lane;
+ * like the parser, it stops at the first whitespace.
+ */
+static int estimateAtoms(const PoolBatch& batch, size_t i, SmilesIndex& index) {
+    if (batch.smiles[i] == nullptr) return 0;
+    index.build(batch.smiles[i], batch.lengths[i]);
+    return index.count(SmilesAtom, index.find(SmilesWhitespace, 0));
+}
+
+/*
+ * Parses and splits molecule i with the worker's molecule, graph and arena,
+ * writing its results into the batch's arrays and returning its status.
+ * Nothing escapes: a failure only sets the status.
+ */
+static int32_t splitMolecule(const PoolBatch& batch, size_t i, PoolWorker& worker) {
+    if (batch.atoms != nullptr) batch.atoms[i] = 0;
+    if (batch.bonds != nullptr) batch.bonds[i] = 0;
+    if (batch.smiles[i] == nullptr) return RETROCHEM_INVALID_ARGUMENT;
+    try {
+        Molecule& mol = worker.mol;
+        mol.clear();
+        worker.arena.reset();
+        SmilesError problem;
+        if (!mol.parseSmiles(batch.smiles[i], batch.lengths[i], problem)) return RETROCHEM_INVALID_SMILES;
+        size_t numAtoms = mol.getAtoms().size();
+        if (batch.atoms != nullptr) batch.atoms[i] = numAtoms;
+        if (batch.bonds != nullptr) batch.bonds[i] = mol.getBonds().size();
+        if (batch.clusters == nullptr && batch.fiedler == nullptr) return RETROCHEM_OK;
+        if (numAtoms > batch.stride) return RETROCHEM_TOO_LARGE;
+
+        worker.graph.moleculeToGraph(mol);
+        size_t row = i * batch.stride;
+        if (batch.clusters != nullptr) {
+            worker.graph.getClusters(worker.clusters);
+            for (size_t j = 0; j < numAtoms; ++j) batch.clusters[row + j] = worker.clusters[j];
+        }
+        if (batch.fiedler != nullptr) {
+            Vector<double> fiedler = worker.graph.getFiedlerVector();
+            for (size_t j = 0; j < numAtoms; ++j) {
+                batch.fiedler[row + j] = j < (size_t) fiedler.size() ? fiedler[j] : 0;
+            }
+        }
+        return RETROCHEM_OK;
+    } catch (...) {
+        return RETROCHEM_INTERNAL_ERROR;
+    }
+}
@@ -0,0 +1,141 @@
+/**
+ * File: retrochem_c.h
+ * -------------------
+ * This file contains RetroCHEM's C interface, for calling the SMILES
+ * parser and the retrosynthetic split from C, or from any language
+ * that can call C (Python through ctypes or cffi, Rust through FFI),
+ * without a subprocess. Only plain C types cross the interface, and
+ * no C++ exception ever does.
+ *
+ * Work runs on a pool: a handle that owns a set of worker threads and,
+ * for each of them, the molecule, graph and arena a worker reuses from
+ * one molecule to the next. A pool is created once and kept for as
+ * long as the service runs. A batch call reads the SMILES where the
+ * caller keeps them, as pointers and lengths, and writes its results
+ * into arrays the caller provides, so nothing is copied into strings
+ * and nothing is allocated for the caller to free.
+ *
+ * The functions and values declared here only ever change by adding
+ * new ones; RETROCHEM_C_API_VERSION counts those additions.
+ */
+
+#ifndef _retrochem_c_h
+#define _retrochem_c_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RETROCHEM_C_API_VERSION 1
+
+/**
+ * Type: retrochem_pool
+ * --------------------
+ * An opaque handle to a pool of workers.
+ */
+typedef struct retrochem_pool retrochem_pool;
+
+/**
+ * Enum: retrochem_status
+ * ----------------------
+ * The result of a call, or of one molecule in a batch.
+ */
+enum retrochem_status {
+    RETROCHEM_OK = 0,
+    RETROCHEM_INVALID_ARGUMENT = 1, /* a null pointer or a value out of range */
+    RETROCHEM_INVALID_SMILES = 2,   /* the SMILES could not be parsed */
+    RETROCHEM_TOO_LARGE = 3,        /* more atoms than a row of the output has room for */
+    RETROCHEM_INTERNAL_ERROR = 4    /* anything else, such as running out of memory */
+};
+
+/**
+ * Enum: retrochem_backend
+ * -----------------------
+ * The algorithms a pool can split molecules with (see molgraph.h).
+ */
+enum retrochem_backend {
+    RETROCHEM_SPECTRAL = 0,  /* sign of the Fiedler vector */
+    RETROCHEM_MULTILEVEL = 1 /* multilevel partitioner; no Fiedler vector */
+};
+
+/**
+ * Function: retrochem_api_version
+ * Usage: if (retrochem_api_version() >= 1) {...}
+ * ----------------------------------------------
+ * Returns the RETROCHEM_C_API_VERSION the library was built with.
+ */
+int retrochem_api_version(void);
+
+/**
+ * Function: retrochem_pool_create
+ * Parameters: threads, backend
+ * Usage: retrochem_pool* pool = retrochem_pool_create(0, RETROCHEM_SPECTRAL);
+ * ---------------------------------------------------------------------------
+ * Starts a pool of worker threads (one per core if threads is 0) that split
+ * molecules with the given backend. Returns NULL if the arguments are out of
+ * range or the pool could not be started.
+ *
+ * The pool never changes the thread settings of the BLAS library, which
+ * belong to the host process. The eigensolver runs inside each worker, so
+ * with a multithreaded BLAS such as OpenBLAS, a host that runs several
+ * workers should limit BLAS to one thread before creating the pool (for
+ * example, OPENBLAS_NUM_THREADS=1), or the workers will compete for cores.
+ */
+retrochem_pool* retrochem_pool_create(int threads, int backend);
+
+/**
+ * Function: retrochem_pool_destroy
+ * Parameters: pool
+ * Usage: retrochem_pool_destroy(pool);
+ * ------------------------------------
+ * Stops the pool's threads and frees everything it holds. NULL is ignored.
+ */
+void retrochem_pool_destroy(retrochem_pool* pool);
+
+/**
+ * Function: retrochem_pool_threads
+ * Parameters: pool
+ * Usage: int threads = retrochem_pool_threads(pool);
+ * --------------------------------------------------
+ * Returns the number of worker threads in the pool, or 0 for NULL.
+ */
+int retrochem_pool_threads(const retrochem_pool* pool);
+
+/**
+ * Function: retrochem_split_batch
+ * Parameters: pool, count, smiles, lengths, stride, clusters, fiedler,
+ *             atoms, bonds, status
+ * Usage: int result = retrochem_split_batch(pool, n, smiles, lengths, 256,
+ *                                           clusters, fiedler, atoms, bonds, status);
+ * ----------------------------------------------------------------------------------
+ * Parses and splits count molecules on the pool's threads. Molecule i is
+ * read from the lengths[i] bytes at smiles[i]; it need not be terminated,
+ * and parsing stops at the first whitespace character.
+ *
+ * Each output array is optional (NULL to skip it). Per molecule, atoms[i]
+ * and bonds[i] receive the atom and bond counts, and status[i] a
+ * retrochem_status. Atom j of molecule i has its cluster (0 or 1) written
+ * to clusters[i * stride + j] and its Fiedler vector entry to
+ * fiedler[i * stride + j]; entries past the molecule's last atom are left
+ * as they were. A molecule with more than stride atoms gets the status
+ * RETROCHEM_TOO_LARGE and its counts, but no clusters. The multilevel
+ * backend writes zeros in place of the Fiedler vector.
+ *
+ * A failure in one molecule never affects the others. Returns RETROCHEM_OK,
+ * or RETROCHEM_INVALID_ARGUMENT (writing nothing) if pool, smiles or lengths
+ * is NULL while count is not 0. Calls on the same pool from several threads
+ * are safe but run one after the other.
+ */
+int retrochem_split_batch(retrochem_pool* pool, size_t count,
+                          const char* const* smiles, const size_t* lengths, size_t stride,
+                          int32_t* clusters, double* fiedler,
+                          int32_t* atoms, int32_t* bonds, int32_t* status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
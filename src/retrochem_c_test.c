@@ -0,0 +1,188 @@
+/**
+ * File: retrochem_c_test.c
+ * ------------------------
+ * This file contains a test program for RetroCHEM's C interface. It is
+ * plain C99, so it also checks that retrochem_c.h compiles without C++.
+ * It splits a small batch on a pool of each backend, including a NULL
+ * molecule, an invalid SMILES, one too large for its row and one followed
+ * by a name, then checks the statuses, the counts, the untouched entries
+ * past each molecule and that calling again gives the same results. A
+ * second batch of molecules of 300 atoms or more checks that the pool
+ * splits them on its threads as it would on one.
+ *
+ * Build it against every RetroCHEM source file except parse_predict.cpp,
+ * which has its own main, and the Stanford C++ library, for example:
+ *
+ *     g++ -std=c++17 -O2 -c <RetroCHEM sources>
+ *     cc -std=c99 -c src/retrochem_c_test.c
+ *     g++ *.o -o retrochem_c_test -llapack -lblas -pthread
+ *
+ * It prints each failed check and returns 1 if there was one.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "retrochem_c.h"
+
+#define NUM_MOLECULES 6
+#define STRIDE 16
+#define NUM_LARGE 8
+#define LARGE_STRIDE 384
+
+static int failures = 0;
+
+/*
+ * Records a failed check when condition is false.
+ */
+static void check(int condition, const char* what, int molecule) {
+    if (!condition) {
+        fprintf(stderr, "FAILED: %s (molecule %d)\n", what, molecule);
+        failures++;
+    }
+}
+
+/*
+ * Splits the batch on a pool with the given backend and checks the results.
+ */
+static void testBackend(int backend, const char* const* smiles, const size_t* lengths) {
+    static const int32_t expectedStatus[NUM_MOLECULES] = {
+        RETROCHEM_OK, RETROCHEM_OK, RETROCHEM_INVALID_SMILES,
+        RETROCHEM_TOO_LARGE, RETROCHEM_INVALID_ARGUMENT, RETROCHEM_OK
+    };
+    static const int32_t expectedAtoms[NUM_MOLECULES] = {3, 13, 0, 46, 0, 6};
+    static const int32_t expectedBonds[NUM_MOLECULES] = {2, 13, 0, 46, 0, 5};
+    int32_t clusters[NUM_MOLECULES * STRIDE], firstClusters[NUM_MOLECULES * STRIDE];
+    double fiedler[NUM_MOLECULES * STRIDE], firstFiedler[NUM_MOLECULES * STRIDE];
+    int32_t atoms[NUM_MOLECULES], bonds[NUM_MOLECULES], status[NUM_MOLECULES];
+    int i, j, round;
+
+    for (i = 0; i < NUM_MOLECULES * STRIDE; i++) {
+        clusters[i] = -1;
+        fiedler[i] = -2.0;
+    }
+    retrochem_pool* pool = retrochem_pool_create(4, backend);
+    check(pool != NULL, "pool created", -1);
+    if (pool == NULL) return;
+    check(retrochem_pool_threads(pool) == 4, "pool has 4 threads", -1);
+
+    for (round = 0; round < 3; round++) {
+        int result = retrochem_split_batch(pool, NUM_MOLECULES, smiles, lengths, STRIDE,
+                                           clusters, fiedler, atoms, bonds, status);
+        check(result == RETROCHEM_OK, "batch returns RETROCHEM_OK", -1);
+        if (round == 0) {
+            memcpy(firstClusters, clusters, sizeof(clusters));
+            memcpy(firstFiedler, fiedler, sizeof(fiedler));
+        } else {
+            check(memcmp(firstClusters, clusters, sizeof(clusters)) == 0, "clusters repeat", -1);
+            check(memcmp(firstFiedler, fiedler, sizeof(fiedler)) == 0, "Fiedler vectors repeat", -1);
+        }
+    }
+
+    for (i = 0; i < NUM_MOLECULES; i++) {
+        const int32_t* row = clusters + i * STRIDE;
+        const double* vector = fiedler + i * STRIDE;
+        int written = status[i] == RETROCHEM_OK ? atoms[i] : 0;
+        double norm = 0;
+        check(status[i] == expectedStatus[i], "status", i);
+        check(atoms[i] == expectedAtoms[i], "atom count", i);
+        check(bonds[i] == expectedBonds[i], "bond count", i);
+        for (j = 0; j < written; j++) {
+            check(row[j] == 0 || row[j] == 1, "cluster is 0 or 1", i);
+            norm += vector[j] * vector[j];
+        }
+        if (written > 0 && backend == RETROCHEM_SPECTRAL) {
+            check(fabs(norm - 1) < 1e-9, "Fiedler vector has unit length", i);
+        } else if (written > 0) {
+            check(norm == 0, "multilevel writes zeros for the Fiedler vector", i);
+        }
+        for (j = written; j < STRIDE; j++) {
+            check(row[j] == -1 && vector[j] == -2.0, "entries past the molecule are untouched", i);
+        }
+    }
+    retrochem_pool_destroy(pool);
+}
+
+/*
+ * Splits several molecules of 300 atoms or more, which the pool runs on its
+ * threads like any others, and checks them against a pool of one thread.
+ */
+static void testLargeMolecules(void) {
+    static char chains[NUM_LARGE][LARGE_STRIDE + 1];
+    const char* smiles[NUM_LARGE];
+    size_t lengths[NUM_LARGE];
+    int32_t clusters[NUM_LARGE * LARGE_STRIDE], expected[NUM_LARGE * LARGE_STRIDE];
+    int32_t atoms[NUM_LARGE], status[NUM_LARGE];
+    int i, j;
+
+    for (i = 0; i < NUM_LARGE; i++) { /* carbon chains of 300 to 370 atoms with a ring in the middle */
+        int length = 302 + 10 * i;    /* two of the bytes are ring numbers */
+        memset(chains[i], 'C', length);
+        memcpy(chains[i] + length / 2, "C1CCCCC1", 8);
+        smiles[i] = chains[i];
+        lengths[i] = length;
+    }
+    retrochem_pool* single = retrochem_pool_create(1, RETROCHEM_SPECTRAL);
+    retrochem_pool* pool = retrochem_pool_create(4, RETROCHEM_SPECTRAL);
+    check(single != NULL && pool != NULL, "pools created", -1);
+    if (single == NULL || pool == NULL) return;
+    check(retrochem_split_batch(single, NUM_LARGE, smiles, lengths, LARGE_STRIDE,
+                                expected, NULL, NULL, NULL, NULL) == RETROCHEM_OK, "batch on one thread", -1);
+    check(retrochem_split_batch(pool, NUM_LARGE, smiles, lengths, LARGE_STRIDE,
+                                clusters, NULL, atoms, NULL, status) == RETROCHEM_OK, "large batch", -1);
+    for (i = 0; i < NUM_LARGE; i++) {
+        int ones = 0;
+        check(status[i] == RETROCHEM_OK, "status", i);
+        check(atoms[i] == 300 + 10 * i, "atom count", i);
+        for (j = 0; j < atoms[i]; j++) ones += clusters[i * LARGE_STRIDE + j];
+        check(ones > 0 && ones < atoms[i], "both clusters are used", i);
+        check(memcmp(clusters + i * LARGE_STRIDE, expected + i * LARGE_STRIDE,
+                     atoms[i] * sizeof(int32_t)) == 0, "clusters match one thread's", i);
+    }
+    retrochem_pool_destroy(single);
+    retrochem_pool_destroy(pool);
+}
+
+int main(void) {
+    /* the SMILES are read in place from one buffer, so none is terminated */
+    static const char text[] =
+        "CCO CC(=O)Oc1ccccc1C(=O)O C1CC( c1ccccc1CCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCC OCC(O)CO glycerol";
+    const char* smiles[NUM_MOLECULES];
+    size_t lengths[NUM_MOLECULES];
+    int32_t status = -1;
+
+    smiles[0] = text;
+    lengths[0] = 3;
+    smiles[1] = text + 4;
+    lengths[1] = 21;
+    smiles[2] = text + 26;
+    lengths[2] = 5;
+    smiles[3] = text + 32;
+    lengths[3] = strchr(smiles[3], ' ') - smiles[3];
+    smiles[4] = NULL;
+    lengths[4] = 3;
+    smiles[5] = smiles[3] + lengths[3] + 1; /* parsing stops before the name */
+    lengths[5] = strlen(smiles[5]);
+
+    check(retrochem_api_version() == RETROCHEM_C_API_VERSION, "API version", -1);
+    check(retrochem_pool_create(-1, RETROCHEM_SPECTRAL) == NULL, "negative thread count rejected", -1);
+    check(retrochem_pool_create(1, 7) == NULL, "unknown backend rejected", -1);
+    check(retrochem_pool_threads(NULL) == 0, "NULL pool has no threads", -1);
+    retrochem_pool_destroy(NULL);
+    check(retrochem_split_batch(NULL, 1, smiles, lengths, STRIDE, NULL, NULL, NULL, NULL, &status)
+          == RETROCHEM_INVALID_ARGUMENT, "NULL pool rejected", -1);
+    check(status == -1, "rejected batch writes nothing", -1);
+    check(retrochem_split_batch(NULL, 0, NULL, NULL, 0, NULL, NULL, NULL, NULL, NULL)
+          == RETROCHEM_OK, "empty batch accepted", -1);
+
+    testBackend(RETROCHEM_SPECTRAL, smiles, lengths);
+    testBackend(RETROCHEM_MULTILEVEL, smiles, lengths);
+    testLargeMolecules();
+
+    if (failures > 0) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,298 @@
+/**
+ * File: retrosearch.cpp
+ * ---------------------
+ * This file contains the implementation for the RetroSearch interface.
+ * Documentation for each method can be found in the retrosearch.h file.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include "arena.h"
+#include "automorphisms.h"
+#include "molgraph.h"
+#include "rings.h"
+#include "scheduler.h"
+#include "transpositiontable.h"
+#include "retrosearch.h"
+
+// one way of splitting a fragment in two
+struct Disconnection {
+    int bond;                  // bond of the target that is cut
+    double score;              // between 0 and 1, higher is better
+    Vector<int> first, second; // atoms of the target on either side, ascending
+};
+
+// what the workers find out about one fragment of the frontier
+struct Expansion {
+    GraphHash graph;
+    int owner = -1;
+    std::vector<Disconnection> disconnections;
+};
+
+// state kept by each worker thread and reused for every fragment it expands
+struct SearchWorker {
+    MolGraph graph;
+    Automorphisms symmetry;
+    std::vector<char> inFragment;              // membership mask over the target's atoms
+    std::vector<int> adjStart, adjAtom, adjBond, fill; // fragment adjacency in compressed form
+    std::vector<int> parentBond, subtree, order; // depth-first spanning forest
+
+    SearchWorker(SpectrumCache* cache) : graph(SpectralBackend, cache) {}
+};
+
+// one fragment of the frontier, built once per level and read by both passes over it
+struct SearchFragment {
+    MolArena arena;
+    Molecule mol;
+    std::vector<int> targetBond; // bond of the target behind each fragment bond
+
+    SearchFragment() : mol(&arena) {}
+};
+
+// helper function declarations
+static void buildFragment(const Molecule& target, const Vector<int>& atoms, SearchFragment& fragment,
+                          std::vector<char>& inFragment);
+static void findDisconnections(const Vector<int>& atoms, SearchFragment& fragment, const GraphHash& graph,
+                               int branching, SearchWorker& worker, std::vector<Disconnection>& result);
+static void printNode(const Molecule& target, const Vector<RouteNode>& routes, int node, int indent);
+
+RetroSearch::RetroSearch(const SearchOptions& limits, SpectrumCache* spectra) :
+    options(limits), cache(spectra), scheduler(limits.threads) {
+    for (int i = 0; i < scheduler.getNumContexts(); ++i) {
+        workers.emplace_back(new SearchWorker(cache));
+    }
+}
+
+RetroSearch::~RetroSearch() {}
+
+Vector<RouteNode> RetroSearch::search(const Molecule& target) {
+    Vector<RouteNode> nodes;
+    RouteNode root;
+    for (int i = 0; i < target.getAtoms().size(); ++i) root.atoms.add(i);
+    nodes.add(root);
+
+    TranspositionTable table;
+    std::vector<Expansion> expansions;
+    Vector<int> frontier;
+    if (root.atoms.size() > options.minFragmentAtoms) frontier.add(0);
+
+    for (int depth = 0; depth < options.maxDepth && !frontier.isEmpty(); ++depth) {
+        expansions.assign(frontier.size(), Expansion());
+        while (fragments.size() < (size_t) frontier.size()) fragments.emplace_back(new SearchFragment());
+        auto sizeOf = [&](int job) { return nodes[frontier[job]].atoms.size(); };
+
+        // every fragment claims its table entry before any is expanded, so the
+        // smallest node holding a fragment explores it whatever the timing
+        scheduler.run(frontier.size(), sizeOf, [&](int job, int worker) {
+            buildFragment(target, nodes[frontier[job]].atoms, *fragments[job], workers[worker]->inFragment);
+            expansions[job].graph.compute(fragments[job]->mol);
+            table.claim(expansions[job].graph, frontier[job]);
+        });
+        scheduler.run(frontier.size(), sizeOf, [&](int job, int worker) {
+            Expansion& expansion = expansions[job];
+            expansion.owner = table.lookup(expansion.graph);
+            if (expansion.owner != frontier[job]) return; // explored elsewhere
+            findDisconnections(nodes[frontier[job]].atoms, *fragments[job], expansion.graph,
+                               options.branching, *workers[worker], expansion.disconnections);
+        });
+
+        // add the new fragments to the tree in frontier order
+        Vector<int> created;
+        for (int job = 0; job < frontier.size(); ++job) {
+            int id = frontier[job];
+            if (expansions[job].owner != id) {
+                nodes[id].transposition = expansions[job].owner;
+                continue;
+            }
+            for (const Disconnection& disconnection : expansions[job].disconnections) {
+                if (nodes.size() + 2 > options.maxNodes) break;
+                nodes[id].bonds.add(disconnection.bond);
+                for (const Vector<int>* side : {&disconnection.first, &disconnection.second}) {
+                    RouteNode child;
+                    child.atoms = *side;
+                    child.parent = id;
+                    child.depth = depth + 1;
+                    child.score = nodes[id].score * disconnection.score;
+                    nodes[id].children.add(nodes.size());
+                    created.add(nodes.size());
+                    nodes.add(child);
+                }
+            }
+        }
+
+        // carry the best of them on to the next level
+        std::stable_sort(created.begin(), created.end(), [&](int a, int b) {
+            return nodes[a].score > nodes[b].score;
+        });
+        frontier.clear();
+        for (int id : created) {
+            if (frontier.size() == options.beamWidth) break;
+            if (nodes[id].atoms.size() > options.minFragmentAtoms) frontier.add(id);
+        }
+    }
+    return nodes;
+}
+
+void RetroSearch::printRoutes(const Molecule& target, const Vector<RouteNode>& routes) {
+    if (!routes.isEmpty()) printNode(target, routes, 0, 0);
+}
+
+/*
+ * Rebuilds the fragment as a molecule of its own in its arena, and records
+ * which bond of the target each of its bonds came from. inFragment is
+ * scratch space.
+ */
+static void buildFragment(const Molecule& target, const Vector<int>& atoms, SearchFragment& fragment,
+                          std::vector<char>& inFragment) {
+    fragment.mol.clear();
+    fragment.arena.reset();
+    fragment.mol.addFragment(target, atoms);
+
+    // addFragment keeps the target's bond order, so the induced bonds line up
+    ArrayView<Bond*> bonds = target.getBonds();
+    inFragment.assign(target.getAtoms().size(), 0);
+    for (int atom : atoms) inFragment[atom] = 1;
+    fragment.targetBond.clear();
+    for (int i = 0; i < bonds.size(); ++i) {
+        if (inFragment[bonds[i]->getFirstAtom()->getIndex()] &&
+                inFragment[bonds[i]->getSecondAtom()->getIndex()]) {
+            fragment.targetBond.push_back(i);
+        }
+    }
+}
+
+/*
+ * Scores every acyclic bond of the fragment, up to symmetry, as a
+ * disconnection and returns the best few. A cut that splits the fragment evenly scores well, and so
+ * does one whose atoms lie far apart along the Fiedler vector, i.e. across
+ * the fragment's weakest link. Ring bonds are never cut; every other bond is
+ * a bridge, so cutting it always leaves two pieces. graph is the fragment's
+ * hash, which the spectrum and the symmetry both start from.
+ */
+static void findDisconnections(const Vector<int>& atoms, SearchFragment& fragment, const GraphHash& graph,
+                               int branching, SearchWorker& worker, std::vector<Disconnection>& result) {
+    ArrayView<Bond*> bonds = fragment.mol.getBonds();
+    int n = atoms.size();
+    worker.graph.moleculeToGraph(fragment.mol, graph);
+    Vector<double> fiedler = worker.graph.getFiedlerVector();
+    const RingPerception& rings = worker.graph.getRings();
+    worker.symmetry.compute(fragment.mol, graph);
+
+    // compressed adjacency
+    std::vector<int>& start = worker.adjStart;
+    start.assign(n + 1, 0);
+    for (Bond * bond : bonds) {
+        start[bond->getFirstAtom()->getIndex() + 1]++;
+        start[bond->getSecondAtom()->getIndex() + 1]++;
+    }
+    for (int i = 0; i < n; ++i) start[i + 1] += start[i];
+    worker.adjAtom.resize(start[n]);
+    worker.adjBond.resize(start[n]);
+    std::vector<int>& fill = worker.fill;
+    fill.assign(start.begin(), start.end() - 1);
+    for (int i = 0; i < bonds.size(); ++i) {
+        int a = bonds[i]->getFirstAtom()->getIndex(), b = bonds[i]->getSecondAtom()->getIndex();
+        worker.adjAtom[fill[a]] = b;
+        worker.adjBond[fill[a]++] = i;
+        worker.adjAtom[fill[b]] = a;
+        worker.adjBond[fill[b]++] = i;
+    }
+
+    // depth-first spanning forest, then subtree sizes in reverse preorder
+    std::vector<int>& parentBond = worker.parentBond;
+    std::vector<int>& order = worker.order;
+    parentBond.assign(n, -2); // -2 marks an unvisited atom
+    order.clear();
+    for (int rootAtom = 0; rootAtom < n; ++rootAtom) {
+        if (parentBond[rootAtom] != -2) continue;
+        parentBond[rootAtom] = -1;
+        size_t first = order.size();
+        order.push_back(rootAtom);
+        for (size_t next = first; next < order.size(); ++next) {
+            int atom = order[next];
+            for (int k = start[atom]; k < start[atom + 1]; ++k) {
+                if (parentBond[worker.adjAtom[k]] != -2) continue;
+                parentBond[worker.adjAtom[k]] = worker.adjBond[k];
+                order.push_back(worker.adjAtom[k]);
+            }
+        }
+    }
+    std::vector<int>& subtree = worker.subtree;
+    subtree.assign(n, 1);
+    for (int i = n - 1; i > 0; --i) {
+        int atom = order[i], bond = parentBond[atom];
+        if (bond < 0) continue;
+        Bond * edge = bonds[bond];
+        int parent = edge->getFirstAtom()->getIndex() == atom ?
+                     edge->getSecondAtom()->getIndex() : edge->getFirstAtom()->getIndex();
+        subtree[parent] += subtree[atom];
+    }
+
+    // score the bridges, one per orbit: cutting equivalent bonds gives the same pieces
+    double low = 0, high = 0;
+    for (int i = 0; i < fiedler.size(); ++i) {
+        if (i == 0 || fiedler[i] < low) low = fiedler[i];
+        if (i == 0 || fiedler[i] > high) high = fiedler[i];
+    }
+    std::vector<std::pair<double, int>> ranked; // score, bond
+    for (int i = 0; i < bonds.size(); ++i) {
+        if (rings.isRingBond(i) || worker.symmetry.getBondOrbit(i) != i) continue;
+        int a = bonds[i]->getFirstAtom()->getIndex(), b = bonds[i]->getSecondAtom()->getIndex();
+        int side = subtree[parentBond[a] == i ? a : b];
+        double balance = std::min(side, n - side) / (n / 2.0);
+        double spread = high > low ? std::abs(fiedler[a] - fiedler[b]) / (high - low) : 0;
+        ranked.push_back(std::make_pair((balance + spread) / 2, i));
+    }
+    std::stable_sort(ranked.begin(), ranked.end(), [](const std::pair<double, int>& x,
+                                                      const std::pair<double, int>& y) {
+        return x.first > y.first;
+    });
+    if ((int) ranked.size() > branching) ranked.resize(branching);
+
+    // collect the atoms on either side of each chosen cut
+    std::vector<int>& side = worker.order; // the traversal order is no longer needed
+    for (const std::pair<double, int>& cut : ranked) {
+        int a = bonds[cut.second]->getFirstAtom()->getIndex();
+        std::vector<int>& seen = worker.subtree;
+        seen.assign(n, 0);
+        side.assign(1, a);
+        seen[a] = 1;
+        for (size_t next = 0; next < side.size(); ++next) {
+            int atom = side[next];
+            for (int k = start[atom]; k < start[atom + 1]; ++k) {
+                if (worker.adjBond[k] == cut.second || seen[worker.adjAtom[k]]) continue;
+                seen[worker.adjAtom[k]] = 1;
+                side.push_back(worker.adjAtom[k]);
+            }
+        }
+        Disconnection disconnection;
+        disconnection.bond = fragment.targetBond[cut.second];
+        disconnection.score = cut.first;
+        for (int i = 0; i < n; ++i) { // fragment atoms are in ascending target order
+            if (seen[i]) {
+                disconnection.first.add(atoms[i]);
+            } else {
+                disconnection.second.add(atoms[i]);
+            }
+        }
+        result.push_back(disconnection);
+    }
+}
+
+static void printNode(const Molecule& target, const Vector<RouteNode>& routes, int node, int indent) {
+    const RouteNode& route = routes[node];
+    std::cout << std::string(indent, ' ') << "[" << node << "] " << route.atoms.size()
+              << " atoms " << route.atoms;
+    if (route.transposition != -1) std::cout << " (explored at [" << route.transposition << "])";
+    std::cout << std::endl;
+    for (int k = 0; k < route.bonds.size(); ++k) {
+        Bond * bond = target.getBonds()[route.bonds[k]];
+        std::cout << std::string(indent + 2, ' ') << "cut bond " << bond->getFirstAtom()->getIndex()
+                  << "-" << bond->getSecondAtom()->getIndex() << " (score "
+                  << routes[route.children[2 * k]].score / route.score << ")" << std::endl;
+        printNode(target, routes, route.children[2 * k], indent + 4);
+        printNode(target, routes, route.children[2 * k + 1], indent + 4);
+    }
+}
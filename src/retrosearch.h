@@ -0,0 +1,107 @@
+/**
+ * File: retrosearch.h
+ * -------------------
+ * This file contains the interface for the RetroSearch class.
+ * A RetroSearch repeats the single-step disconnection of MolGraph over
+ * several steps: every fragment it finds is split again, giving a tree
+ * of routes from the target molecule down to small building blocks.
+ *
+ * The candidate disconnections of a fragment are its acyclic bonds
+ * (ring systems are never cut), ranked by how evenly they split the
+ * fragment and by how far apart their atoms lie along its Fiedler
+ * vector. The tree is grown one level at a time as a beam search: the
+ * fragments of a level are expanded in parallel, and only the
+ * best-scoring new fragments go on to the next level. A transposition
+ * table makes sure a fragment reached along several routes is only
+ * explored once.
+ */
+
+#ifndef _retrosearch_h
+#define _retrosearch_h
+
+#include <memory>
+#include <vector>
+#include "vector.h"
+#include "molecule.h"
+#include "scheduler.h"
+#include "spectrumcache.h"
+
+// limits and shape of a multi-step search
+struct SearchOptions {
+    int maxDepth = 4;          // disconnection steps below the target
+    int maxNodes = 1000;       // fragments in the route tree, including the target
+    int beamWidth = 16;        // fragments expanded per level
+    int branching = 3;         // disconnections tried per fragment
+    int minFragmentAtoms = 4;  // fragments this small are building blocks
+    int threads = 0;           // worker threads (0 means one per core)
+};
+
+// one fragment in the route tree
+struct RouteNode {
+    Vector<int> atoms;        // atoms of the target making up the fragment, ascending
+    int parent = -1;          // fragment this one was split from (-1 for the target)
+    int depth = 0;            // disconnection steps from the target
+    double score = 1;         // product of the scores of the disconnections leading here
+    int transposition = -1;   // node exploring the same fragment, if not this one
+    Vector<int> bonds;        // bond of the target cut by each disconnection
+    Vector<int> children;     // disconnection k makes children[2k] and children[2k + 1]
+};
+
+// per-thread and per-fragment state, defined in retrosearch.cpp
+struct SearchWorker;
+struct SearchFragment;
+
+class RetroSearch {
+public:
+    /**
+     * Constructor: RetroSearch
+     * Parameters: options, cache
+     * Usage: RetroSearch search(options, &cache);
+     * -------------------------------------------
+     * Initializes a search with the given limits and starts its worker
+     * threads, which are kept for every later call to search. Fragment
+     * spectra are shared through the cache if one is given.
+     */
+    RetroSearch(const SearchOptions& options = SearchOptions(), SpectrumCache* cache = nullptr);
+
+    /**
+     * Destructor: ~RetroSearch
+     * Usage: (implicit)
+     * -----------------
+     * Stops the worker threads.
+     */
+    ~RetroSearch();
+
+    /**
+     * Function: search
+     * Parameters: target
+     * Usage: Vector<RouteNode> routes = search.search(mol);
+     * -----------------------------------------------------
+     * Explores disconnections of the target and returns the route tree.
+     * Node 0 is the target itself; every other node is a fragment created
+     * by a disconnection of its parent. Nodes whose fragment was already
+     * explored elsewhere in the tree point there and have no children.
+     * The result depends only on the target and the options, not on the
+     * number of threads. Calls on the same search must not overlap.
+     */
+    Vector<RouteNode> search(const Molecule& target);
+
+    /**
+     * Function: printRoutes
+     * Parameters: target, routes
+     * Usage: search.printRoutes(mol, routes);
+     * ---------------------------------------
+     * Prints the route tree as an indented list of fragments and the bonds
+     * cut to make them.
+     */
+    void printRoutes(const Molecule& target, const Vector<RouteNode>& routes);
+
+private:
+    SearchOptions options;
+    SpectrumCache* cache;
+    BatchScheduler scheduler;
+    std::vector<std::unique_ptr<SearchWorker>> workers;     // one per scheduler context
+    std::vector<std::unique_ptr<SearchFragment>> fragments; // one per fragment of the frontier
+};
+
+#endif
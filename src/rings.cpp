@@ -0,0 +1,404 @@
+/**
+ * File: rings.cpp
+ * ---------------
+ * This file contains the implementation for the RingPerception interface.
+ * Documentation for each method can be found in the rings.h file.
+ */
+
+#include <algorithm>
+#include <numeric>
+#include "rings.h"
+
+// helper function declarations
+static int findRoot(std::vector<int>& parent, int x);
+static void breadthFirst(int root, const std::vector<int>& start, const std::vector<int>& nbr,
+                         const std::vector<int>& nbrEdge, const std::vector<int>& rank, int maxRank,
+                         int maxDepth, std::vector<int>& dist, std::vector<int>& parentEdge,
+                         std::vector<int>& order);
+
+RingPerception::RingPerception() : natoms(0), nbonds(0), numSystems(0), numRings(0), numCandidates(0) {}
+
+RingPerception::RingPerception(const Molecule& mol) :
+    natoms(0), nbonds(0), numSystems(0), numRings(0), numCandidates(0) {
+    perceive(mol);
+}
+
+void RingPerception::perceive(const Molecule& mol) {
+    buildAdjacency(mol);
+    findRingBonds();
+    findRingSystems();
+}
+
+bool RingPerception::isRingAtom(int atom) const {
+    return ringAtoms.test(atom);
+}
+
+bool RingPerception::isRingBond(int bond) const {
+    return ringBonds.test(bond);
+}
+
+int RingPerception::getRingSystem(int atom) const {
+    return atomSystem[atom];
+}
+
+int RingPerception::getNumRingSystems() const {
+    return numSystems;
+}
+
+int RingPerception::getNumRings() const {
+    return numRings;
+}
+
+Vector<int> RingPerception::getRingAtoms(int ring) const {
+    BitVector members(natoms);
+    const BitVector& bonds = sssr[ring];
+    for (size_t b = bonds.findFirst(); b < bonds.size(); b = bonds.findNext(b)) {
+        members.set(bondAtoms[2 * b]);
+        members.set(bondAtoms[2 * b + 1]);
+    }
+    Vector<int> result;
+    for (size_t a = members.findFirst(); a < members.size(); a = members.findNext(a)) {
+        result.add(a);
+    }
+    return result;
+}
+
+Vector<int> RingPerception::getRingBonds(int ring) const {
+    Vector<int> result;
+    const BitVector& bonds = sssr[ring];
+    for (size_t b = bonds.findFirst(); b < bonds.size(); b = bonds.findNext(b)) {
+        result.add(b);
+    }
+    return result;
+}
+
+const BitVector& RingPerception::getRingBondSet(int ring) const {
+    return sssr[ring];
+}
+
+void RingPerception::buildAdjacency(const Molecule& mol) {
+    ArrayView<Atom*> atoms = mol.getAtoms();
+    ArrayView<Bond*> bonds = mol.getBonds();
+    natoms = atoms.size();
+    nbonds = bonds.size();
+    bondAtoms.assign(2 * nbonds, 0);
+    adjStart.assign(natoms + 1, 0);
+    for (int i = 0; i < nbonds; ++i) {
+        bondAtoms[2 * i] = bonds[i]->getFirstAtom()->getIndex();
+        bondAtoms[2 * i + 1] = bonds[i]->getSecondAtom()->getIndex();
+        if (bondAtoms[2 * i] == bondAtoms[2 * i + 1]) continue; // a bond to itself is never a ring bond
+        adjStart[bondAtoms[2 * i] + 1]++;
+        adjStart[bondAtoms[2 * i + 1] + 1]++;
+    }
+    std::partial_sum(adjStart.begin(), adjStart.end(), adjStart.begin());
+    adjAtom.assign(adjStart[natoms], 0);
+    adjBond.assign(adjStart[natoms], 0);
+    fill.assign(adjStart.begin(), adjStart.end() - 1);
+    for (int i = 0; i < nbonds; ++i) {
+        int a = bondAtoms[2 * i], b = bondAtoms[2 * i + 1];
+        if (a == b) continue;
+        adjAtom[fill[a]] = b;
+        adjBond[fill[a]++] = i;
+        adjAtom[fill[b]] = a;
+        adjBond[fill[b]++] = i;
+    }
+}
+
+/*
+ * A bond is a ring bond exactly when it is not a bridge. Bridges are found
+ * with Tarjan's low-link algorithm, written iteratively so that long chains
+ * (polymers, peptides) cannot overflow the call stack.
+ */
+void RingPerception::findRingBonds() {
+    discovered.assign(natoms, -1);
+    low.assign(natoms, 0);
+    ringBonds.assign(nbonds);
+    ringAtoms.assign(natoms);
+    int time = 0;
+    for (int i = 0; i < nbonds; ++i) {
+        if (bondAtoms[2 * i] != bondAtoms[2 * i + 1]) ringBonds.set(i); // cleared below if a bridge
+    }
+    for (int start = 0; start < natoms; ++start) {
+        if (discovered[start] != -1) continue;
+        discovered[start] = low[start] = time++;
+        stack.push_back({start, -1, adjStart[start]});
+        while (!stack.empty()) {
+            Frame& frame = stack.back();
+            int v = frame.atom;
+            if (frame.next < adjStart[v + 1]) {
+                int k = frame.next++;
+                int w = adjAtom[k];
+                if (adjBond[k] == frame.parentBond) continue;
+                if (discovered[w] == -1) {
+                    discovered[w] = low[w] = time++;
+                    stack.push_back({w, adjBond[k], adjStart[w]});
+                } else {
+                    low[v] = std::min(low[v], discovered[w]);
+                }
+            } else {
+                int parentBond = frame.parentBond;
+                stack.pop_back();
+                if (!stack.empty()) {
+                    int p = stack.back().atom;
+                    low[p] = std::min(low[p], low[v]);
+                    if (low[v] > discovered[p]) ringBonds.reset(parentBond);
+                }
+            }
+        }
+    }
+    for (size_t b = ringBonds.findFirst(); b < ringBonds.size(); b = ringBonds.findNext(b)) {
+        ringAtoms.set(bondAtoms[2 * b]);
+        ringAtoms.set(bondAtoms[2 * b + 1]);
+    }
+}
+
+void RingPerception::findRingSystems() {
+    parent.resize(natoms);
+    std::iota(parent.begin(), parent.end(), 0);
+    for (size_t b = ringBonds.findFirst(); b < ringBonds.size(); b = ringBonds.findNext(b)) {
+        int x = findRoot(parent, bondAtoms[2 * b]);
+        int y = findRoot(parent, bondAtoms[2 * b + 1]);
+        if (x != y) parent[x] = y;
+    }
+
+    // number the systems in order of their lowest atom
+    atomSystem.assign(natoms, -1);
+    rootSystem.assign(natoms, -1);
+    numSystems = 0;
+    for (int a = 0; a < natoms; ++a) {
+        if (!ringAtoms.test(a)) continue;
+        int root = findRoot(parent, a);
+        if (rootSystem[root] == -1) {
+            if (numSystems == (int) systemMembers.size()) systemMembers.emplace_back();
+            systemMembers[numSystems].clear();
+            rootSystem[root] = numSystems++;
+        }
+        atomSystem[a] = rootSystem[root];
+        systemMembers[atomSystem[a]].push_back(a);
+    }
+
+    // per-atom and per-bond numbering within each system, shared by all systems
+    local.assign(natoms, -1);
+    bondEdge.assign(nbonds, -1);
+    for (int system = 0; system < numSystems; ++system) {
+        const std::vector<int>& systemAtoms = systemMembers[system];
+        for (size_t i = 0; i < systemAtoms.size(); ++i) local[systemAtoms[i]] = i;
+    }
+    numRings = 0;
+    for (int system = 0; system < numSystems; ++system) {
+        findSmallestRings(systemMembers[system]);
+    }
+}
+
+/*
+ * Computes the SSSR of one ring system. The system's ring bonds are renumbered
+ * locally so that cycles are bitsets over the system only. Candidates are
+ * Vismara's prototypes: for each root r, only vertices ranked below r whose
+ * shortest path from r stays below r are used, which generates each relevant
+ * cycle from its highest-ranked vertex alone. Candidates are then taken in
+ * order of length and kept when independent of those already chosen.
+ *
+ * Candidates are produced in rounds of doubling maximum length, with the
+ * searches cut off at half that length. Since rings are small, the first round
+ * usually finds them all after only looking at each atom's neighbourhood, which
+ * keeps large fused systems close to linear.
+ */
+void RingPerception::findSmallestRings(const std::vector<int>& systemAtoms) {
+    int n = systemAtoms.size();
+
+    // local adjacency restricted to ring bonds of this system
+    start.assign(n + 1, 0);
+    nbr.clear();
+    nbrEdge.clear();
+    edgeBond.clear();
+    for (int i = 0; i < n; ++i) {
+        int a = systemAtoms[i];
+        for (int k = adjStart[a]; k < adjStart[a + 1]; ++k) {
+            if (!ringBonds.test(adjBond[k])) continue;
+            nbr.push_back(local[adjAtom[k]]);
+            nbrEdge.push_back(adjBond[k]);
+            if (adjAtom[k] > a) edgeBond.push_back(adjBond[k]);
+        }
+        start[i + 1] = nbr.size();
+    }
+    int m = edgeBond.size();
+    for (int e = 0; e < m; ++e) bondEdge[edgeBond[e]] = e;
+    for (int& e : nbrEdge) e = bondEdge[e];
+    int rings = m - n + 1; // cyclomatic number of a connected graph
+
+    if (rings == 1) { // an isolated ring is the whole system
+        BitVector& bonds = addRing();
+        for (int e = 0; e < m; ++e) bonds.set(edgeBond[e]);
+        return;
+    }
+
+    // rank vertices by degree so that branch points become roots last
+    // (ties by index, as a stable sort would leave them, without its buffer)
+    byDegree.resize(n);
+    rank.resize(n);
+    std::iota(byDegree.begin(), byDegree.end(), 0);
+    std::sort(byDegree.begin(), byDegree.end(), [&](int x, int y) {
+        int dx = start[x + 1] - start[x], dy = start[y + 1] - start[y];
+        return dx < dy || (dx == dy && x < y);
+    });
+    for (int i = 0; i < n; ++i) rank[byDegree[i]] = i;
+
+    // candidates are generated in rounds of growing length, since rings are usually small
+    fullDist.assign(n, -1);
+    dist.assign(n, -1);
+    parentEdge.resize(n);
+    mark.assign(n, -1);
+    if ((int) basis.size() < m) basis.resize(m); // a row is only read once it has a pivot
+    hasPivot.assign(m, false);
+    int stamp = 0, found = 0;
+    for (int lower = 0, upper = 8; found < rings && lower <= n; lower = upper, upper *= 2) {
+        numCandidates = 0;
+        for (int r = 0; r < n; ++r) {
+            breadthFirst(r, start, nbr, nbrEdge, rank, n, upper / 2, fullDist, parentEdge, fullOrder);
+            breadthFirst(r, start, nbr, nbrEdge, rank, rank[r], upper / 2, dist, parentEdge, order);
+
+            // y is usable if its shortest path from r in the whole system stays below r
+            auto usable = [&](int y) {
+                return y == r || (dist[y] != -1 && dist[y] == fullDist[y]);
+            };
+            auto otherEnd = [&](int y, int e) {
+                for (int k = start[y]; k < start[y + 1]; ++k) {
+                    if (nbrEdge[k] == e) return nbr[k];
+                }
+                return -1;
+            };
+            auto pathEdges = [&](int y, BitVector& edges) {
+                while (y != r) {
+                    edges.set(parentEdge[y]);
+                    y = otherEnd(y, parentEdge[y]);
+                }
+            };
+            auto disjoint = [&](int y, int z) { // P(r, y) and P(r, z) only share r
+                stamp++;
+                for (int v = y; v != r; v = otherEnd(v, parentEdge[v])) mark[v] = stamp;
+                for (int v = z; v != r; v = otherEnd(v, parentEdge[v])) {
+                    if (mark[v] == stamp) return false;
+                }
+                return true;
+            };
+            auto inRound = [&](int length) {
+                return length > lower && length <= upper;
+            };
+
+            for (int y : order) {
+                if (y == r || !usable(y)) continue;
+                predecessors.clear(); // (vertex, edge) one step closer to r
+                for (int k = start[y]; k < start[y + 1]; ++k) {
+                    int z = nbr[k];
+                    if (!usable(z)) continue;
+                    if (dist[z] + 1 == dist[y]) {
+                        predecessors.push_back(std::make_pair(z, nbrEdge[k]));
+                    } else if (dist[z] == dist[y] && rank[z] < rank[y] &&
+                               inRound(2 * dist[y] + 1) && disjoint(y, z)) { // odd cycle
+                        Cycle& cycle = addCandidate(m, 2 * dist[y] + 1);
+                        pathEdges(y, cycle.bonds);
+                        pathEdges(z, cycle.bonds);
+                        cycle.bonds.set(nbrEdge[k]);
+                    }
+                }
+                if (!inRound(2 * dist[y])) continue;
+                for (size_t i = 0; i < predecessors.size(); ++i) { // even cycles
+                    for (size_t j = i + 1; j < predecessors.size(); ++j) {
+                        int p = predecessors[i].first, q = predecessors[j].first;
+                        if (!disjoint(p, q)) continue;
+                        Cycle& cycle = addCandidate(m, 2 * dist[y]);
+                        pathEdges(p, cycle.bonds);
+                        pathEdges(q, cycle.bonds);
+                        cycle.bonds.set(predecessors[i].second);
+                        cycle.bonds.set(predecessors[j].second);
+                    }
+                }
+            }
+            for (int v : fullOrder) fullDist[v] = -1; // reset only what this root touched
+            for (int v : order) dist[v] = -1;
+        }
+
+        // Gaussian elimination over GF(2), shortest candidates first, ties in the order found
+        byLength.resize(numCandidates);
+        std::iota(byLength.begin(), byLength.end(), 0);
+        std::sort(byLength.begin(), byLength.end(), [&](int x, int y) {
+            return candidates[x].length < candidates[y].length ||
+                   (candidates[x].length == candidates[y].length && x < y);
+        });
+        for (int candidate : byLength) {
+            if (found == rings) break;
+            const Cycle& cycle = candidates[candidate];
+            reduced = cycle.bonds;
+            size_t pivot = reduced.findFirst();
+            while (pivot < reduced.size() && hasPivot[pivot]) {
+                reduced ^= basis[pivot];
+                pivot = reduced.findFirst();
+            }
+            if (pivot == reduced.size()) continue; // dependent on shorter rings
+            basis[pivot] = reduced;
+            hasPivot[pivot] = true;
+            BitVector& bonds = addRing();
+            for (size_t e = cycle.bonds.findFirst(); e < cycle.bonds.size(); e = cycle.bonds.findNext(e)) {
+                bonds.set(edgeBond[e]);
+            }
+            found++;
+        }
+    }
+}
+
+/*
+ * Returns the next free candidate, cleared to hold the given number of edges.
+ * Candidates left over from earlier rounds and molecules keep their storage.
+ */
+RingPerception::Cycle& RingPerception::addCandidate(int edges, int length) {
+    if (numCandidates == (int) candidates.size()) candidates.emplace_back();
+    Cycle& cycle = candidates[numCandidates++];
+    cycle.bonds.assign(edges);
+    cycle.length = length;
+    return cycle;
+}
+
+/*
+ * Returns the next ring of the SSSR, cleared to hold a bit per bond of the
+ * molecule. Rings left over from earlier molecules keep their storage.
+ */
+BitVector& RingPerception::addRing() {
+    if (numRings == (int) sssr.size()) sssr.emplace_back();
+    BitVector& bonds = sssr[numRings++];
+    bonds.assign(nbonds);
+    return bonds;
+}
+
+static int findRoot(std::vector<int>& parent, int x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+/*
+ * Breadth-first search from root over the vertices ranked below maxRank (plus
+ * the root itself), at most maxDepth steps deep. dist must be -1 for every
+ * vertex on entry; unreached vertices keep -1. order lists the reached vertices
+ * in the order they were visited, so the caller can reset just those.
+ */
+static void breadthFirst(int root, const std::vector<int>& start, const std::vector<int>& nbr,
+                         const std::vector<int>& nbrEdge, const std::vector<int>& rank, int maxRank,
+                         int maxDepth, std::vector<int>& dist, std::vector<int>& parentEdge,
+                         std::vector<int>& order) {
+    order.clear();
+    dist[root] = 0;
+    order.push_back(root);
+    for (size_t head = 0; head < order.size(); ++head) {
+        int v = order[head];
+        if (dist[v] == maxDepth) continue;
+        for (int k = start[v]; k < start[v + 1]; ++k) {
+            int w = nbr[k];
+            if (dist[w] != -1 || rank[w] >= maxRank) continue;
+            dist[w] = dist[v] + 1;
+            parentEdge[w] = nbrEdge[k];
+            order.push_back(w);
+        }
+    }
+}
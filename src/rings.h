@@ -0,0 +1,172 @@
+/**
+ * File: rings.h
+ * -------------
+ * This file contains the interface for the RingPerception class.
+ * RingPerception finds which atoms and bonds of a Molecule lie on
+ * rings, groups them into ring systems (fused, bridged and spiro
+ * rings that share atoms), and computes the smallest set of smallest
+ * rings (SSSR) of each system.
+ *
+ * Ring bonds are found with a single bridge-finding pass, so the
+ * common questions (is this bond in a ring? which ring system?) are
+ * linear in the size of the molecule. The SSSR is computed per ring
+ * system from Vismara's candidate cycles, stored as bond bitsets and
+ * reduced by Gaussian elimination over GF(2); isolated rings skip the
+ * elimination entirely.
+ */
+
+#ifndef _rings_h
+#define _rings_h
+
+#include <vector>
+#include "vector.h"
+#include "bitvector.h"
+#include "molecule.h"
+
+class RingPerception {
+public:
+    /**
+     * Constructor: RingPerception
+     * Usage: RingPerception rings;
+     * ----------------------------
+     * Initializes an empty RingPerception object.
+     */
+    RingPerception();
+
+    /**
+     * Constructor: RingPerception
+     * Parameters: mol
+     * Usage: RingPerception rings(mol);
+     * ---------------------------------
+     * Initializes a RingPerception object and perceives the rings of the molecule.
+     */
+    RingPerception(const Molecule& mol);
+
+    /**
+     * Function: perceive
+     * Parameters: mol
+     * Usage: rings.perceive(mol);
+     * ---------------------------
+     * Finds the ring atoms, ring bonds, ring systems and SSSR of the molecule,
+     * replacing the results of any previous call.
+     */
+    void perceive(const Molecule& mol);
+
+    /**
+     * Function: isRingAtom
+     * Parameters: atom
+     * Usage: if (rings.isRingAtom(atom)) {...}
+     * ----------------------------------------
+     * Returns true if the atom (by index) lies on at least one ring.
+     */
+    bool isRingAtom(int atom) const;
+
+    /**
+     * Function: isRingBond
+     * Parameters: bond
+     * Usage: if (rings.isRingBond(bond)) {...}
+     * ----------------------------------------
+     * Returns true if the bond (by index) lies on at least one ring.
+     * Cutting a ring bond never separates a molecule into two pieces.
+     */
+    bool isRingBond(int bond) const;
+
+    /**
+     * Function: getRingSystem
+     * Parameters: atom
+     * Usage: int system = rings.getRingSystem(atom);
+     * ----------------------------------------------
+     * Returns the ring system the atom belongs to, or -1 for acyclic atoms.
+     */
+    int getRingSystem(int atom) const;
+
+    /**
+     * Function: getNumRingSystems
+     * Usage: int n = rings.getNumRingSystems();
+     * -----------------------------------------
+     * Returns the number of ring systems in the molecule.
+     */
+    int getNumRingSystems() const;
+
+    /**
+     * Function: getNumRings
+     * Usage: int n = rings.getNumRings();
+     * -----------------------------------
+     * Returns the number of rings in the SSSR (the cyclomatic number).
+     */
+    int getNumRings() const;
+
+    /**
+     * Function: getRingAtoms
+     * Parameters: ring
+     * Usage: Vector<int> atoms = rings.getRingAtoms(ring);
+     * ----------------------------------------------------
+     * Returns the indices of the atoms on the given SSSR ring, in increasing order.
+     */
+    Vector<int> getRingAtoms(int ring) const;
+
+    /**
+     * Function: getRingBonds
+     * Parameters: ring
+     * Usage: Vector<int> bonds = rings.getRingBonds(ring);
+     * ----------------------------------------------------
+     * Returns the indices of the bonds on the given SSSR ring, in increasing order.
+     */
+    Vector<int> getRingBonds(int ring) const;
+
+    /**
+     * Function: getRingBondSet
+     * Parameters: ring
+     * Usage: const BitVector& bonds = rings.getRingBondSet(ring);
+     * -----------------------------------------------------------
+     * Returns the bonds on the given SSSR ring as a bitset over bond indices.
+     */
+    const BitVector& getRingBondSet(int ring) const;
+
+private:
+    // a candidate cycle: its bonds (local to a ring system) and its length
+    struct Cycle {
+        BitVector bonds;
+        int length;
+    };
+
+    // a step of the iterative bridge search
+    struct Frame {
+        int atom, parentBond, next;
+    };
+
+    // molecule graph in compressed adjacency form
+    int natoms, nbonds;
+    std::vector<int> bondAtoms;   // two entries per bond
+    std::vector<int> adjStart;    // neighbours of atom i are adjStart[i] .. adjStart[i + 1] - 1
+    std::vector<int> adjAtom, adjBond;
+
+    // results; only the first numRings entries of sssr are rings of this molecule
+    BitVector ringAtoms, ringBonds;
+    std::vector<int> atomSystem;
+    int numSystems, numRings;
+    std::vector<BitVector> sssr;
+
+    // workspaces reused from one molecule to the next
+    std::vector<int> fill, discovered, low, parent, rootSystem, local, bondEdge;
+    std::vector<Frame> stack;
+    std::vector<std::vector<int>> systemMembers;
+    std::vector<int> start, nbr, nbrEdge, edgeBond, byDegree, rank;
+    std::vector<int> fullDist, dist, parentEdge, order, fullOrder, mark, byLength;
+    std::vector<std::pair<int, int>> predecessors;
+    std::vector<Cycle> candidates;  // only the first numCandidates are in use
+    int numCandidates;
+    std::vector<BitVector> basis;
+    std::vector<bool> hasPivot;
+    BitVector reduced;
+
+    // stages of perception
+    void buildAdjacency(const Molecule& mol);
+    void findRingBonds();
+    void findRingSystems();
+    void findSmallestRings(const std::vector<int>& systemAtoms);
+    Cycle& addCandidate(int edges, int length);
+    BitVector& addRing();
+};
+
+#endif
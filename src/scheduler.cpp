@@ -0,0 +1,101 @@
+/**
+ * File: scheduler.cpp
+ * -------------------
+ * This file contains the implementation for the BatchScheduler interface.
+ * Documentation for each method can be found in the scheduler.h file.
+ */
+
+#include <algorithm>
+#include <climits>
+#include "blasthreads.h"
+#include "scheduler.h"
+
+BatchScheduler::BatchScheduler(int threads, int large, bool limit) : largeMolecule(large), limitBlas(limit), next(0) {
+    // without control over BLAS threads, a large molecule could only ever use one core
+    if (!limitBlas || !setBlasThreads(1)) largeMolecule = INT_MAX;
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < threads; ++i) {
+        workers.push_back(std::thread(&BatchScheduler::workerLoop, this, i));
+    }
+}
+
+BatchScheduler::~BatchScheduler() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void BatchScheduler::run(int count, const std::function<int(int)>& sizeOf,
+                         const std::function<void(int, int)>& work) {
+    // route each job by size; the biggest small jobs go first so the round ends evenly
+    std::vector<std::pair<int, int>> small;
+    std::vector<int> large, smallJobs;
+    for (int job = 0; job < count; ++job) {
+        int size = sizeOf(job);
+        if (size >= largeMolecule) {
+            large.push_back(job);
+        } else {
+            small.push_back(std::make_pair(-size, job));
+        }
+    }
+    std::sort(small.begin(), small.end());
+    for (const std::pair<int, int>& job : small) smallJobs.push_back(job.second);
+
+    // small lane: one molecule per worker, single-threaded BLAS
+    if (!smallJobs.empty()) {
+        if (limitBlas) setBlasThreads(1);
+        std::unique_lock<std::mutex> guard(lock);
+        jobs = &smallJobs;
+        this->work = &work;
+        next = 0;
+        active = workers.size();
+        failure = nullptr;
+        generation++;
+        wake.notify_all();
+        done.wait(guard, [&] { return active == 0; });
+        jobs = nullptr;
+        this->work = nullptr;
+        if (failure) std::rethrow_exception(failure);
+    }
+
+    // large lane: one molecule at a time, BLAS may use every core
+    if (!large.empty()) {
+        if (limitBlas) setBlasThreads(workers.size());
+        for (int job : large) work(job, workers.size());
+        if (limitBlas) setBlasThreads(1);
+    }
+}
+
+int BatchScheduler::getNumWorkers() const {
+    return workers.size();
+}
+
+int BatchScheduler::getNumContexts() const {
+    return workers.size() + 1;
+}
+
+void BatchScheduler::workerLoop(int worker) {
+    if (limitBlas) setBlasThreads(1); // only affects this thread where the BLAS library supports it
+    int seen = 0;
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        wake.wait(guard, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        const std::vector<int>& round = *jobs;
+        const std::function<void(int, int)>& task = *work;
+        guard.unlock();
+        try {
+            for (size_t i = next++; i < round.size(); i = next++) task(round[i], worker);
+        } catch (...) {
+            std::lock_guard<std::mutex> failed(lock);
+            if (!failure) failure = std::current_exception();
+            next = round.size(); // abandon the rest of the round
+        }
+        guard.lock();
+        if (--active == 0) done.notify_all();
+    }
+}
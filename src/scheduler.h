@@ -0,0 +1,104 @@
+/**
+ * File: scheduler.h
+ * -----------------
+ * This file contains the interface for the BatchScheduler class.
+ * The BatchScheduler runs a batch of jobs (one per molecule) on a
+ * pool of persistent worker threads, choosing between two kinds of
+ * parallelism by molecule size:
+ * - small molecules run one per core, with BLAS/LAPACK limited to a
+ *   single thread so the eigensolver does not oversubscribe the cores;
+ * - large molecules run one at a time in a separate lane whose
+ *   eigensolve may use every core through a multithreaded BLAS.
+ * The two lanes run one after the other, so every core stays busy
+ * either way and BLAS thread limits never have to change while a
+ * worker is inside LAPACK. The large lane only pays off when BLAS
+ * threads can be controlled: with a reference BLAS, or in a scheduler
+ * told to leave the BLAS thread settings alone (with OpenBLAS they are
+ * shared by the whole process, which may not be ours), every molecule
+ * goes to the pool instead.
+ */
+
+#ifndef _scheduler_h
+#define _scheduler_h
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class BatchScheduler {
+public:
+    /**
+     * Constructor: BatchScheduler
+     * Parameters: threads, largeMolecule, limitBlas
+     * Usage: BatchScheduler scheduler(threads, largeMolecule);
+     * --------------------------------------------------------
+     * Starts a pool of worker threads (one per core if threads is 0).
+     * Molecules with at least largeMolecule atoms go to the large lane;
+     * pass INT_MAX when the work does not call BLAS. If limitBlas is false,
+     * the BLAS thread limits are never changed and there is no large lane.
+     */
+    BatchScheduler(int threads = 0, int largeMolecule = 300, bool limitBlas = true);
+
+    /**
+     * Destructor: ~BatchScheduler
+     * Usage: (implicit)
+     * -----------------
+     * Stops and joins the worker threads.
+     */
+    ~BatchScheduler();
+
+    /**
+     * Function: run
+     * Parameters: count, sizeOf, work
+     * Usage: scheduler.run(count, sizeOf, work);
+     * ------------------------------------------
+     * Calls work(job, worker) once for every job from 0 to count - 1 and
+     * returns when all of them are done. sizeOf(job) estimates the number of
+     * atoms, which decides the lane; it is called on the calling thread, one
+     * job after another, before any work starts. worker identifies the calling thread,
+     * from 0 to getNumContexts() - 1, so callers can keep per-thread state
+     * indexed by it. An exception thrown by work is rethrown here.
+     */
+    void run(int count, const std::function<int(int)>& sizeOf,
+             const std::function<void(int, int)>& work);
+
+    /**
+     * Function: getNumWorkers
+     * Usage: int n = scheduler.getNumWorkers();
+     * -----------------------------------------
+     * Returns the number of worker threads in the pool.
+     */
+    int getNumWorkers() const;
+
+    /**
+     * Function: getNumContexts
+     * Usage: Vector<State> states(scheduler.getNumContexts());
+     * --------------------------------------------------------
+     * Returns the number of distinct worker values work can be called with:
+     * one per pool thread, plus one for the large lane.
+     */
+    int getNumContexts() const;
+
+private:
+    std::vector<std::thread> workers;
+    int largeMolecule;
+    bool limitBlas;
+
+    // the current round of small jobs
+    std::mutex lock;
+    std::condition_variable wake, done;
+    const std::vector<int>* jobs = nullptr;
+    const std::function<void(int, int)>* work = nullptr;
+    std::atomic<size_t> next;
+    int generation = 0, active = 0;
+    bool stopping = false;
+    std::exception_ptr failure;
+
+    void workerLoop(int worker);
+};
+
+#endif
@@ -0,0 +1,214 @@
+/**
+ * File: smilesindex.cpp
+ * ---------------------
+ * This file contains the implementation for the SmilesIndex interface.
+ * Documentation for each method can be found in the smilesindex.h file.
+ */
+
+#include <cstring>
+#include "bitvector.h"
+#include "cpufeatures.h"
+#include "smilesindex.h"
+
+#ifdef RETROCHEM_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+// classifies 64 bytes of input into one bitmask word per class
+typedef void (*ClassifyFunction)(const char* block, uint64_t masks[NumSmilesClasses]);
+
+// helper function declarations
+static ClassifyFunction selectClassifier();
+
+SmilesIndex::SmilesIndex() : length(0) {}
+
+SmilesIndex::SmilesIndex(const char* smiles, size_t len) : length(0) {
+    build(smiles, len);
+}
+
+void SmilesIndex::build(const char* smiles, size_t len) {
+    static const ClassifyFunction classify = selectClassifier();
+    length = len;
+    size_t fullBlocks = len / 64;
+    blocks.resize((len + 63) / 64);
+    for (size_t i = 0; i < fullBlocks; ++i) {
+        classify(smiles + 64 * i, blocks[i].masks);
+    }
+    if (fullBlocks < blocks.size()) { // pad the tail; NUL bytes fall into no class
+        char tail[64] = {0};
+        std::memcpy(tail, smiles + 64 * fullBlocks, len - 64 * fullBlocks);
+        classify(tail, blocks[fullBlocks].masks);
+    }
+}
+
+bool SmilesIndex::is(SmilesClass cls, size_t pos) const {
+    if (pos >= length) return false;
+    return (blocks[pos / 64].masks[cls] >> (pos % 64)) & 1;
+}
+
+size_t SmilesIndex::find(SmilesClass cls, size_t pos) const {
+    if (pos >= length) return length;
+    size_t word = pos / 64;
+    uint64_t bits = blocks[word].masks[cls] & (~uint64_t(0) << (pos % 64));
+    while (bits == 0) {
+        if (++word == blocks.size()) return length;
+        bits = blocks[word].masks[cls];
+    }
+    return 64 * word + lowestSetBit(bits);
+}
+
+size_t SmilesIndex::count(SmilesClass cls) const {
+    size_t total = 0;
+    for (const Block& block : blocks) total += countSetBits(block.masks[cls]);
+    return total;
+}
+
+size_t SmilesIndex::count(SmilesClass cls, size_t end) const {
+    if (end >= length) return count(cls);
+    size_t total = 0;
+    for (size_t word = 0; word < end / 64; ++word) total += countSetBits(blocks[word].masks[cls]);
+    if (end % 64 != 0) total += countSetBits(blocks[end / 64].masks[cls] & ((uint64_t(1) << (end % 64)) - 1));
+    return total;
+}
+
+size_t SmilesIndex::size() const {
+    return length;
+}
+
+/**
+ ******************************************************************
+ ******************************************************************
+ *************************CLASSIFIERS*****************************
+ ******************************************************************
+ ******************************************************************
+ */
+
+// lookup table from byte to its class bits, shared by the scalar path
+struct ClassTable {
+    uint16_t bits[256];
+    ClassTable() {
+        std::memset(bits, 0, sizeof(bits));
+        for (int c = 'A'; c <= 'Z'; ++c) bits[c] |= 1 << SmilesAtom;
+        for (int c = 'a'; c <= 'z'; ++c) bits[c] |= 1 << SmilesAtom;
+        for (int c = '0'; c <= '9'; ++c) bits[c] |= 1 << SmilesRingClosure;
+        bits[unsigned('%')] |= 1 << SmilesRingClosure;
+        bits[unsigned('[')] |= 1 << SmilesBracketOpen;
+        bits[unsigned(']')] |= 1 << SmilesBracketClose;
+        bits[unsigned('(')] |= 1 << SmilesBranchOpen;
+        bits[unsigned(')')] |= 1 << SmilesBranchClose;
+        for (const char* c = "-=#$:/\\"; *c; ++c) bits[(unsigned char) *c] |= 1 << SmilesBond;
+        bits[unsigned('.')] |= 1 << SmilesSeparator;
+        for (const char* c = " \t\r\n\v\f"; *c; ++c) bits[(unsigned char) *c] |= 1 << SmilesWhitespace;
+    }
+};
+
+static void classifyScalar(const char* block, uint64_t masks[NumSmilesClasses]) {
+    static const ClassTable table;
+    std::memset(masks, 0, sizeof(uint64_t) * NumSmilesClasses);
+    for (int i = 0; i < 64; ++i) {
+        uint16_t bits = table.bits[(unsigned char) block[i]];
+        while (bits != 0) {
+            int cls = lowestSetBit(bits);
+            masks[cls] |= uint64_t(1) << i;
+            bits &= bits - 1;
+        }
+    }
+}
+
+#ifdef RETROCHEM_X86_DISPATCH
+
+// SSE4.2: PCMPESTRM compares each 16-byte chunk against a set of characters or ranges
+__attribute__((target("sse4.2")))
+static uint64_t matchSSE42(const char* block, const char* set, int setLength, bool ranges) {
+    __m128i needles = _mm_loadu_si128(reinterpret_cast<const __m128i*>(set));
+    uint64_t mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        __m128i match = ranges ?
+            _mm_cmpestrm(needles, setLength, chunk, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_BIT_MASK) :
+            _mm_cmpestrm(needles, setLength, chunk, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK);
+        mask |= uint64_t(uint16_t(_mm_cvtsi128_si32(match))) << (16 * i);
+    }
+    return mask;
+}
+
+__attribute__((target("sse4.2")))
+static void classifySSE42(const char* block, uint64_t masks[NumSmilesClasses]) {
+    // character sets are padded to 16 bytes so the loads stay in bounds
+    static const char letters[16] = "AZaz";
+    static const char digits[16] = "09";
+    static const char percent[16] = "%";
+    static const char open[16] = "[";
+    static const char close[16] = "]";
+    static const char branchOpen[16] = "(";
+    static const char branchClose[16] = ")";
+    static const char bonds[16] = "-=#$:/\\";
+    static const char separators[16] = ".";
+    static const char whitespace[16] = " \t\r\n\v\f";
+    masks[SmilesAtom] = matchSSE42(block, letters, 4, true);
+    masks[SmilesRingClosure] = matchSSE42(block, digits, 2, true) | matchSSE42(block, percent, 1, false);
+    masks[SmilesBracketOpen] = matchSSE42(block, open, 1, false);
+    masks[SmilesBracketClose] = matchSSE42(block, close, 1, false);
+    masks[SmilesBranchOpen] = matchSSE42(block, branchOpen, 1, false);
+    masks[SmilesBranchClose] = matchSSE42(block, branchClose, 1, false);
+    masks[SmilesBond] = matchSSE42(block, bonds, 7, false);
+    masks[SmilesSeparator] = matchSSE42(block, separators, 1, false);
+    masks[SmilesWhitespace] = matchSSE42(block, whitespace, 6, false);
+}
+
+// AVX2: byte compares over two 32-byte halves, collapsed with MOVEMASK
+__attribute__((target("avx2")))
+static uint64_t movemask64(__m256i low, __m256i high) {
+    return uint64_t(uint32_t(_mm256_movemask_epi8(low))) |
+           (uint64_t(uint32_t(_mm256_movemask_epi8(high))) << 32);
+}
+
+__attribute__((target("avx2")))
+static __m256i equals(__m256i chunk, char c) {
+    return _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(c));
+}
+
+// signed compares reject bytes >= 0x80, which are negative
+__attribute__((target("avx2")))
+static __m256i inRange(__m256i chunk, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(chunk, _mm256_set1_epi8(lo - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), chunk));
+}
+
+__attribute__((target("avx2")))
+static void classifyAVX2(const char* block, uint64_t masks[NumSmilesClasses]) {
+    __m256i half[2];
+    half[0] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    half[1] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+    __m256i result[NumSmilesClasses][2];
+    for (int i = 0; i < 2; ++i) {
+        __m256i chunk = half[i];
+        __m256i folded = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20)); // lowercase letters
+        result[SmilesAtom][i] = inRange(folded, 'a', 'z');
+        result[SmilesRingClosure][i] = _mm256_or_si256(inRange(chunk, '0', '9'), equals(chunk, '%'));
+        result[SmilesBracketOpen][i] = equals(chunk, '[');
+        result[SmilesBracketClose][i] = equals(chunk, ']');
+        result[SmilesBranchOpen][i] = equals(chunk, '(');
+        result[SmilesBranchClose][i] = equals(chunk, ')');
+        result[SmilesBond][i] = _mm256_or_si256(
+            _mm256_or_si256(_mm256_or_si256(equals(chunk, '-'), equals(chunk, '=')),
+                            _mm256_or_si256(equals(chunk, '#'), equals(chunk, '$'))),
+            _mm256_or_si256(_mm256_or_si256(equals(chunk, ':'), equals(chunk, '/')),
+                            equals(chunk, '\\')));
+        result[SmilesSeparator][i] = equals(chunk, '.');
+        result[SmilesWhitespace][i] = _mm256_or_si256(equals(chunk, ' '), inRange(chunk, '\t', '\r'));
+    }
+    for (int cls = 0; cls < NumSmilesClasses; ++cls) {
+        masks[cls] = movemask64(result[cls][0], result[cls][1]);
+    }
+}
+
+#endif
+
+static ClassifyFunction selectClassifier() {
+#ifdef RETROCHEM_X86_DISPATCH
+    if (cpuSupportsAVX2()) return classifyAVX2;
+    if (cpuSupportsSSE42()) return classifySSE42;
+#endif
+    return classifyScalar;
+}
@@ -0,0 +1,126 @@
+/**
+ * File: smilesindex.h
+ * -------------------
+ * This file contains the interface for the SmilesIndex class.
+ * A SmilesIndex is a structural pre-pass over a SMILES string: every
+ * byte is classified into bitmasks (atoms, brackets, ring closures,
+ * branches, bonds and separators), 64 bytes per word, so that a record
+ * can be sized up (where its name starts, roughly how many atoms it
+ * has) with word-wide counts instead of a parse. The parser itself
+ * does not use it: every byte of a SMILES string is part of a token,
+ * so there is nothing for it to skip. Classification uses AVX2 or
+ * SSE4.2 when the processor supports it and falls back to a lookup
+ * table otherwise.
+ */
+
+#ifndef _smilesindex_h
+#define _smilesindex_h
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Enum: SmilesClass
+ * -----------------
+ * The structural classes a SMILES byte can fall into.
+ */
+enum SmilesClass {
+    SmilesAtom,         // alphabetic characters (organic subset and aromatic atoms)
+    SmilesBracketOpen,  // '['
+    SmilesBracketClose, // ']'
+    SmilesRingClosure,  // digits and '%'
+    SmilesBranchOpen,   // '('
+    SmilesBranchClose,  // ')'
+    SmilesBond,         // '-', '=', '#', '$', ':', '/', '\'
+    SmilesSeparator,    // '.' (disconnected components)
+    SmilesWhitespace,   // ends the SMILES string
+    NumSmilesClasses
+};
+
+class SmilesIndex {
+public:
+    /**
+     * Constructor: SmilesIndex
+     * Usage: SmilesIndex index;
+     * -------------------------
+     * Initializes an empty index.
+     */
+    SmilesIndex();
+
+    /**
+     * Constructor: SmilesIndex
+     * Parameters: smiles, length
+     * Usage: SmilesIndex index(smiles, length);
+     * -----------------------------------------
+     * Initializes an index over the first length bytes of smiles.
+     */
+    SmilesIndex(const char* smiles, size_t length);
+
+    /**
+     * Function: build
+     * Parameters: smiles, length
+     * Usage: index.build(smiles, length);
+     * -----------------------------------
+     * Classifies every byte of the buffer, replacing any previous index.
+     * The storage of the previous index is reused.
+     */
+    void build(const char* smiles, size_t length);
+
+    /**
+     * Function: is
+     * Parameters: cls, pos
+     * Usage: if (index.is(SmilesAtom, pos)) {...}
+     * -------------------------------------------
+     * Returns true if the byte at pos belongs to the given class.
+     */
+    bool is(SmilesClass cls, size_t pos) const;
+
+    /**
+     * Function: find
+     * Parameters: cls, pos
+     * Usage: size_t next = index.find(SmilesBracketClose, pos);
+     * ---------------------------------------------------------
+     * Returns the position of the first byte at or after pos that belongs
+     * to the given class, or size() if there is none.
+     */
+    size_t find(SmilesClass cls, size_t pos) const;
+
+    /**
+     * Function: count
+     * Parameters: cls
+     * Usage: size_t atoms = index.count(SmilesAtom);
+     * ----------------------------------------------
+     * Returns the number of bytes that belong to the given class.
+     */
+    size_t count(SmilesClass cls) const;
+
+    /**
+     * Function: count
+     * Parameters: cls, end
+     * Usage: size_t atoms = index.count(SmilesAtom, index.find(SmilesWhitespace, 0));
+     * -------------------------------------------------------------------------------
+     * Returns the number of bytes before position end that belong to the
+     * given class.
+     */
+    size_t count(SmilesClass cls, size_t end) const;
+
+    /**
+     * Function: size
+     * Usage: size_t length = index.size();
+     * ------------------------------------
+     * Returns the number of bytes covered by the index.
+     */
+    size_t size() const;
+
+private:
+    // one bitmask word per class for each 64-byte block of input
+    struct Block {
+        uint64_t masks[NumSmilesClasses];
+    };
+
+    std::vector<Block> blocks;
+    size_t length;
+};
+
+#endif
@@ -0,0 +1,59 @@
+/**
+ * File: spectrumcache.cpp
+ * -----------------------
+ * This file contains the implementation for the SpectrumCache interface.
+ * Documentation for each method can be found in the spectrumcache.h file.
+ */
+
+#include "spectrumcache.h"
+
+SpectrumCache::SpectrumCache(size_t capacity) : hits(0), misses(0) {
+    capacityPerShard = (capacity + NUM_SHARDS - 1) / NUM_SHARDS;
+}
+
+bool SpectrumCache::lookup(const GraphHash& graph, std::vector<double>& basis,
+                           std::vector<double>& eigenvalues) {
+    Shard& shard = shards[graph.getShard(NUM_SHARDS)];
+    static thread_local std::vector<int> mapping; // reused by the thread from one lookup to the next
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto range = shard.entries.equal_range(graph.getHash());
+    for (auto it = range.first; it != range.second; ++it) {
+        const Entry& entry = it->second;
+        if (!entry.graph.isomorphism(graph, mapping)) continue; // a hash collision
+        size_t n = mapping.size();
+        basis.resize(entry.basis.size());
+        for (size_t column = 0; column < basis.size(); column += n) {
+            for (size_t i = 0; i < n; ++i) basis[column + mapping[i]] = entry.basis[column + i];
+        }
+        eigenvalues = entry.eigenvalues;
+        hits++;
+        return true;
+    }
+    misses++;
+    return false;
+}
+
+void SpectrumCache::insert(const GraphHash& graph, const double* basis, int columns,
+                           const double* eigenvalues) {
+    Shard& shard = shards[graph.getShard(NUM_SHARDS)];
+    static thread_local std::vector<int> mapping;
+    std::lock_guard<std::mutex> guard(shard.lock);
+    if (shard.entries.size() >= capacityPerShard) return;
+    auto range = shard.entries.equal_range(graph.getHash());
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.graph.isomorphism(graph, mapping)) return; // another thread got there first
+    }
+    int n = graph.getNumAtoms();
+    Entry& entry = shard.entries.emplace(graph.getHash(), Entry())->second;
+    entry.graph = graph;
+    entry.basis.assign(basis, basis + columns * n);
+    entry.eigenvalues.assign(eigenvalues, eigenvalues + n);
+}
+
+size_t SpectrumCache::getHits() const {
+    return hits;
+}
+
+size_t SpectrumCache::getMisses() const {
+    return misses;
+}
@@ -0,0 +1,95 @@
+/**
+ * File: spectrumcache.h
+ * ---------------------
+ * This file contains the interface for the SpectrumCache class.
+ * The SpectrumCache remembers the Laplacian eigenvalues of every
+ * molecular graph it is given, with a basis of the eigenspace of the
+ * second smallest one, keyed by the graph's Weisfeiler-Lehman hash.
+ * When the same scaffold or fragment comes up again, its spectrum is
+ * mapped onto the new atom numbering instead of being recomputed by
+ * the eigensolver. The whole eigenspace is kept, not one Fiedler
+ * vector, because choosing the vector depends on the atom numbering:
+ * each graph picks its own from the basis (see MolGraph).
+ *
+ * The cache is split into independently locked shards so that many
+ * worker threads can share one instance.
+ */
+
+#ifndef _spectrumcache_h
+#define _spectrumcache_h
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "graphhash.h"
+
+class SpectrumCache {
+public:
+    /**
+     * Constructor: SpectrumCache
+     * Parameters: capacity
+     * Usage: SpectrumCache cache(capacity);
+     * -------------------------------------
+     * Initializes an empty cache holding at most capacity spectra. Once it is
+     * full, new spectra are no longer stored.
+     */
+    SpectrumCache(size_t capacity = 100000);
+
+    /**
+     * Function: lookup
+     * Parameters: graph, basis, eigenvalues
+     * Usage: if (cache.lookup(graph, basis, eigenvalues)) {...}
+     * ---------------------------------------------------------
+     * Returns true if an isomorphic graph is cached, in which case basis and
+     * eigenvalues are filled in. The basis vectors are stored one after
+     * another (column-major), with their entries in the atom order of graph.
+     */
+    bool lookup(const GraphHash& graph, std::vector<double>& basis, std::vector<double>& eigenvalues);
+
+    /**
+     * Function: insert
+     * Parameters: graph, basis, columns, eigenvalues
+     * Usage: cache.insert(graph, basis, columns, eigenvalues);
+     * --------------------------------------------------------
+     * Stores the spectrum of the graph, unless the cache is full: its
+     * ascending eigenvalues, one per atom, and the given number of basis
+     * vectors of the second smallest one's eigenspace, column-major.
+     */
+    void insert(const GraphHash& graph, const double* basis, int columns, const double* eigenvalues);
+
+    /**
+     * Function: getHits
+     * Usage: size_t hits = cache.getHits();
+     * -------------------------------------
+     * Returns the number of lookups that found a cached spectrum.
+     */
+    size_t getHits() const;
+
+    /**
+     * Function: getMisses
+     * Usage: size_t misses = cache.getMisses();
+     * -----------------------------------------
+     * Returns the number of lookups that did not.
+     */
+    size_t getMisses() const;
+
+private:
+    struct Entry {
+        GraphHash graph;
+        std::vector<double> basis, eigenvalues;
+    };
+
+    struct Shard {
+        std::mutex lock;
+        std::unordered_multimap<uint64_t, Entry> entries;
+    };
+
+    static const int NUM_SHARDS = 64;
+    Shard shards[NUM_SHARDS];
+    size_t capacityPerShard;
+    std::atomic<size_t> hits, misses;
+};
+
+#endif
@@ -0,0 +1,208 @@
+/**
+ * File: trace.cpp
+ * ---------------
+ * This file contains the implementation for the trace interface.
+ * Documentation for each function can be found in the trace.h file.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "trace.h"
+
+typedef std::chrono::steady_clock Clock;
+
+// one finished span
+struct TraceEvent {
+    const char* name;
+    long line;
+    Clock::time_point start, end;
+    const char* argNames[TraceSpan::MAX_ARGS];
+    long argValues[TraceSpan::MAX_ARGS];
+    int numArgs;
+};
+
+// the spans recorded by one thread and not yet written
+struct ThreadBuffer {
+    int tid;
+    std::vector<TraceEvent> events;
+    bool named = false; // whether the thread's name has been written
+};
+
+// a thread writes out its own buffer once it holds this many events
+static const size_t MAX_EVENTS_PER_THREAD = 1 << 16;
+
+static std::atomic<bool> tracing(false);
+static std::atomic<int> generation(0); // bumped by startTrace, so stale buffers are not reused
+static double rate = 0;
+static Clock::time_point origin;
+static std::mutex registryLock; // guards the buffer list and the file
+static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+static std::ofstream traceFile;
+
+// the molecule the current thread is working on
+static thread_local bool sampled = false;
+static thread_local long currentLine = 0;
+static thread_local ThreadBuffer* threadBuffer = nullptr;
+static thread_local int threadGeneration = -1;
+
+// helper function declarations
+static bool isSampled(long id);
+static void record(const TraceEvent& event);
+static void writeBuffer(ThreadBuffer& buffer);
+static void writeEvent(std::ostream& out, const TraceEvent& event, int tid);
+
+bool startTrace(const std::string& path, double sampleRate) {
+    std::lock_guard<std::mutex> guard(registryLock);
+    buffers.clear();
+    generation++;
+    rate = sampleRate;
+    origin = Clock::now();
+    traceFile.close();
+    traceFile.clear();
+    traceFile.open(path);
+    traceFile << std::fixed << std::setprecision(3);
+    traceFile << "[{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"RetroCHEM, sample rate "
+              << std::defaultfloat << rate << std::fixed << "\"}}";
+    traceFile.flush();
+    tracing = bool(traceFile);
+    return tracing;
+}
+
+bool flushTrace() {
+    std::lock_guard<std::mutex> guard(registryLock);
+    for (const std::unique_ptr<ThreadBuffer>& buffer : buffers) writeBuffer(*buffer);
+    traceFile.flush();
+    return bool(traceFile);
+}
+
+bool stopTrace() {
+    bool written = flushTrace();
+    tracing = false;
+    std::lock_guard<std::mutex> guard(registryLock);
+    traceFile << "\n]\n";
+    traceFile.close();
+    buffers.clear();
+    return written && bool(traceFile);
+}
+
+bool isTracing() {
+    return tracing;
+}
+
+TraceMolecule::TraceMolecule(long id) {
+    active = tracing && isSampled(id);
+    sampled = active;
+    currentLine = id;
+    if (active) start = Clock::now();
+}
+
+TraceMolecule::~TraceMolecule() {
+    if (!active) return;
+    TraceEvent event{"molecule", currentLine, start, Clock::now(), {}, {}, 0};
+    if (atoms >= 0) {
+        event.argNames[0] = "atoms";
+        event.argValues[0] = atoms;
+        event.argNames[1] = "bonds";
+        event.argValues[1] = bonds;
+        event.numArgs = 2;
+    }
+    record(event);
+    sampled = false;
+}
+
+void TraceMolecule::setCounts(int numAtoms, int numBonds) {
+    atoms = numAtoms;
+    bonds = numBonds;
+}
+
+TraceSpan::TraceSpan(const char* spanName) : name(spanName), active(sampled) {
+    if (active) start = Clock::now();
+}
+
+TraceSpan::~TraceSpan() {
+    if (!active) return;
+    TraceEvent event{name, currentLine, start, Clock::now(), {}, {}, numArgs};
+    for (int i = 0; i < numArgs; ++i) {
+        event.argNames[i] = argNames[i];
+        event.argValues[i] = argValues[i];
+    }
+    record(event);
+}
+
+void TraceSpan::setArg(const char* argName, long value) {
+    if (!active || numArgs == MAX_ARGS) return;
+    argNames[numArgs] = argName;
+    argValues[numArgs++] = value;
+}
+
+/*
+ * Samples by a hash of the id rather than at random, so the same molecules
+ * are traced every time the same input is run.
+ */
+static bool isSampled(long id) {
+    if (rate >= 1) return true;
+    uint64_t x = uint64_t(id) + 0x9e3779b97f4a7c15ULL; // splitmix64 finalizer
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return (x >> 11) * (1.0 / 9007199254740992.0) < rate;
+}
+
+/*
+ * Appends the event to the calling thread's buffer, registering the buffer
+ * the first time the thread records anything, and writing it out when it is
+ * full. Only registration and writing lock.
+ */
+static void record(const TraceEvent& event) {
+    if (threadBuffer == nullptr || threadGeneration != generation) {
+        std::lock_guard<std::mutex> guard(registryLock);
+        if (!tracing) return;
+        buffers.emplace_back(new ThreadBuffer());
+        buffers.back()->tid = buffers.size();
+        threadBuffer = buffers.back().get();
+        threadGeneration = generation;
+    }
+    threadBuffer->events.push_back(event);
+    if (threadBuffer->events.size() >= MAX_EVENTS_PER_THREAD) {
+        std::lock_guard<std::mutex> guard(registryLock);
+        writeBuffer(*threadBuffer);
+    }
+}
+
+/*
+ * Appends a buffer's events to the file, after the thread's name the first
+ * time, and empties it. The caller holds registryLock. Every event starts
+ * with the comma that separates it from the one before, so the file is a
+ * valid trace, short of the closing bracket, after every write.
+ */
+static void writeBuffer(ThreadBuffer& buffer) {
+    if (!buffer.named && !buffer.events.empty()) {
+        traceFile << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer.tid
+                  << ",\"args\":{\"name\":\"worker " << buffer.tid << "\"}}";
+        buffer.named = true;
+    }
+    for (const TraceEvent& event : buffer.events) {
+        traceFile << ",\n";
+        writeEvent(traceFile, event, buffer.tid);
+    }
+    buffer.events.clear();
+}
+
+/*
+ * Writes a complete ("X") event with its times in microseconds since
+ * startTrace.
+ */
+static void writeEvent(std::ostream& out, const TraceEvent& event, int tid) {
+    std::chrono::duration<double, std::micro> ts = event.start - origin, dur = event.end - event.start;
+    out << "{\"name\":\"" << event.name << "\",\"cat\":\"retrochem\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+        << ",\"ts\":" << ts.count() << ",\"dur\":" << dur.count() << ",\"args\":{\"line\":" << event.line;
+    for (int i = 0; i < event.numArgs; ++i) {
+        out << ",\"" << event.argNames[i] << "\":" << event.argValues[i];
+    }
+    out << "}}";
+}
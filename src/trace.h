@@ -0,0 +1,161 @@
+/**
+ * File: trace.h
+ * -------------
+ * This file contains the interface for per-molecule tracing.
+ * When tracing is on, a sample of the molecules being processed have
+ * the stages of their pipeline (parsing, graph construction,
+ * eigensolving, clustering...) recorded as timed spans, tagged with the
+ * input line, atom and bond counts, and the thread that ran them. The
+ * trace is written as Chrome trace-event JSON, which chrome://tracing
+ * and Perfetto (ui.perfetto.dev) can display. It uses the array form,
+ * whose closing bracket viewers do not require, so the part of the trace
+ * already written stays readable if the run is killed.
+ *
+ * Each thread records into its own buffer, so tracing rarely makes the
+ * workers wait for each other, and a span costs a single thread-local
+ * check for molecules that are not sampled. Buffers are written out at
+ * every flushTrace, and by their own thread whenever one fills up, so
+ * no event is ever dropped and memory stays bounded on long runs.
+ */
+
+#ifndef _trace_h
+#define _trace_h
+
+#include <chrono>
+#include <string>
+
+/**
+ * Function: startTrace
+ * Parameters: path, sampleRate
+ * Usage: if (!startTrace("trace.json", 0.01)) {...}
+ * -------------------------------------------------
+ * Creates the trace file and turns tracing on. About sampleRate (between
+ * 0 and 1) of the molecules are traced; which ones depends only on their
+ * ids, so a rerun traces the same molecules. Returns false, leaving
+ * tracing off, if the file could not be created.
+ */
+bool startTrace(const std::string& path, double sampleRate);
+
+/**
+ * Function: flushTrace
+ * Usage: if (!flushTrace()) {...}
+ * -------------------------------
+ * Writes out the events recorded so far. Must be called while no other
+ * thread is inside a traced molecule, such as between two batches of
+ * work. Returns false if the file could not be written.
+ */
+bool flushTrace();
+
+/**
+ * Function: stopTrace
+ * Usage: if (!stopTrace()) {...}
+ * ------------------------------
+ * Writes out the remaining events, turns tracing off and closes the trace
+ * file. Must be called while no other thread is inside a traced molecule.
+ * Returns false if the file could not be written.
+ */
+bool stopTrace();
+
+/**
+ * Function: isTracing
+ * Usage: if (isTracing()) {...}
+ * -----------------------------
+ * Returns true between startTrace and stopTrace.
+ */
+bool isTracing();
+
+/**
+ * Class: TraceMolecule
+ * --------------------
+ * Marks the molecule the current thread is working on for as long as
+ * the object lives, and records the whole of that time as a "molecule"
+ * span if the molecule is sampled.
+ */
+class TraceMolecule {
+public:
+    /**
+     * Constructor: TraceMolecule
+     * Parameters: id
+     * Usage: TraceMolecule traced(line);
+     * ----------------------------------
+     * Starts work on molecule id (normally its input line) and decides
+     * whether it is sampled.
+     */
+    TraceMolecule(long id);
+
+    /**
+     * Destructor: ~TraceMolecule
+     * Usage: (implicit)
+     * -----------------
+     * Ends work on the molecule, recording its span if it was sampled.
+     */
+    ~TraceMolecule();
+
+    TraceMolecule(const TraceMolecule&) = delete;
+    TraceMolecule& operator=(const TraceMolecule&) = delete;
+
+    /**
+     * Function: setCounts
+     * Parameters: atoms, bonds
+     * Usage: traced.setCounts(atoms, bonds);
+     * --------------------------------------
+     * Records the size of the molecule once it is known.
+     */
+    void setCounts(int atoms, int bonds);
+
+private:
+    bool active;
+    std::chrono::steady_clock::time_point start;
+    int atoms = -1, bonds = -1;
+};
+
+/**
+ * Class: TraceSpan
+ * ----------------
+ * Times one stage of work on the current molecule, from construction to
+ * destruction, if that molecule is sampled.
+ */
+class TraceSpan {
+public:
+    /**
+     * Constructor: TraceSpan
+     * Parameters: name
+     * Usage: TraceSpan span("eig_sym");
+     * ---------------------------------
+     * Starts a span. The name must be a string literal (it is not copied).
+     */
+    TraceSpan(const char* name);
+
+    /**
+     * Destructor: ~TraceSpan
+     * Usage: (implicit)
+     * -----------------
+     * Ends the span and records it.
+     */
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    /**
+     * Function: setArg
+     * Parameters: name, value
+     * Usage: span.setArg("atoms", n);
+     * -------------------------------
+     * Attaches a number to the span (up to MAX_ARGS of them). The name must
+     * be a string literal.
+     */
+    void setArg(const char* name, long value);
+
+    static const int MAX_ARGS = 3;
+
+private:
+    const char* name;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+    const char* argNames[MAX_ARGS];
+    long argValues[MAX_ARGS];
+    int numArgs = 0;
+};
+
+#endif
@@ -0,0 +1,41 @@
+/**
+ * File: transpositiontable.cpp
+ * ----------------------------
+ * This file contains the implementation for the TranspositionTable interface.
+ * Documentation for each method can be found in the transpositiontable.h file.
+ */
+
+#include "transpositiontable.h"
+
+TranspositionTable::TranspositionTable() : count(0) {}
+
+int TranspositionTable::claim(const GraphHash& graph, int node) {
+    Shard& shard = shards[graph.getShard(NUM_SHARDS)];
+    static thread_local std::vector<int> mapping;
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto range = shard.entries.equal_range(graph.getHash());
+    for (auto it = range.first; it != range.second; ++it) {
+        Entry& entry = it->second;
+        if (!entry.graph.isomorphism(graph, mapping)) continue; // a hash collision
+        if (node < entry.owner) entry.owner = node;
+        return entry.owner;
+    }
+    shard.entries.insert(std::make_pair(graph.getHash(), Entry{graph, node}));
+    count++;
+    return node;
+}
+
+int TranspositionTable::lookup(const GraphHash& graph) {
+    Shard& shard = shards[graph.getShard(NUM_SHARDS)];
+    static thread_local std::vector<int> mapping;
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto range = shard.entries.equal_range(graph.getHash());
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.graph.isomorphism(graph, mapping)) return it->second.owner;
+    }
+    return -1;
+}
+
+int TranspositionTable::size() const {
+    return count;
+}
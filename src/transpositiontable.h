@@ -0,0 +1,78 @@
+/**
+ * File: transpositiontable.h
+ * --------------------------
+ * This file contains the interface for the TranspositionTable class.
+ * A multi-step search reaches the same fragment along many routes;
+ * the TranspositionTable records which search node owns each distinct
+ * fragment so that it is only explored there. Fragments are keyed by
+ * their Weisfeiler-Lehman hash and confirmed with an isomorphism check,
+ * so a hash collision never merges two different fragments.
+ *
+ * Like the SpectrumCache, the table is split into independently locked
+ * shards so that many worker threads can share one instance.
+ */
+
+#ifndef _transpositiontable_h
+#define _transpositiontable_h
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include "graphhash.h"
+
+class TranspositionTable {
+public:
+    /**
+     * Constructor: TranspositionTable
+     * Usage: TranspositionTable table;
+     * --------------------------------
+     * Initializes an empty table.
+     */
+    TranspositionTable();
+
+    /**
+     * Function: claim
+     * Parameters: graph, node
+     * Usage: int owner = table.claim(graph, node);
+     * --------------------------------------------
+     * Records node as a holder of the fragment and returns the fragment's
+     * owner so far: the smallest node that has claimed it. Because the
+     * smallest node always wins, the final owners do not depend on the
+     * order in which threads make their claims.
+     */
+    int claim(const GraphHash& graph, int node);
+
+    /**
+     * Function: lookup
+     * Parameters: graph
+     * Usage: int owner = table.lookup(graph);
+     * ---------------------------------------
+     * Returns the owner of the fragment, or -1 if it was never claimed.
+     */
+    int lookup(const GraphHash& graph);
+
+    /**
+     * Function: size
+     * Usage: int fragments = table.size();
+     * ------------------------------------
+     * Returns the number of distinct fragments in the table.
+     */
+    int size() const;
+
+private:
+    struct Entry {
+        GraphHash graph;
+        int owner;
+    };
+
+    struct Shard {
+        std::mutex lock;
+        std::unordered_multimap<uint64_t, Entry> entries;
+    };
+
+    static const int NUM_SHARDS = 64;
+    Shard shards[NUM_SHARDS];
+    std::atomic<int> count;
+};
+
+#endif